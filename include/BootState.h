@@ -0,0 +1,33 @@
+/*
+Dial state kept in RTC memory across resets
+*/
+
+#ifndef _BOOT_STATE_H
+#define _BOOT_STATE_H
+
+#include <Arduino.h>
+
+#define BOOT_STATE_MAGIC 0x53425254 // "SBRT"
+#define BOOT_STATE_MAX_DIALS 16
+
+// Lives in RTC slow memory, which is not cleared by software, watchdog or brownout
+// resets. It is only trusted when the magic and checksum match.
+struct BootSnapshot
+{
+    uint32_t magic;
+    uint8_t dialCount;
+    uint8_t dialPos[BOOT_STATE_MAX_DIALS];
+    int16_t runs;
+    int16_t overs;
+    int16_t wickets;
+    uint32_t bootCount;
+    uint32_t lastBootToScoreMs; // boot to first score of the previous boot, for tracking
+    uint32_t checksum;
+};
+
+bool restoreBootSnapshot(BootSnapshot &snapshot);
+void saveBootSnapshot(const int *dialPos, int dialCount, int runs, int overs, int wickets);
+void saveBootToScore(unsigned long ms);
+void invalidateBootSnapshot();
+
+#endif
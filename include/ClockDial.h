@@ -6,34 +6,63 @@ Class to control Dial
 #define _CLOCK_DIAL_H
 
 #include <M5StickC.h>
-#include <Adafruit_PWMServoDriver.h>
+#include "PwmBank.h"
 
 #define MAX_POS 9620 // equivalent to 360 degree rotation
 #define NUM_ITEMS 10 // Number of things to show. Not tested with number of items that are not clean divisor of MAX_POS
 #define MIN_POS_INCR MAX_POS / NUM_ITEMS
+#define TICK_INCR 10 // MAX_POS units the hands advance per tick
+#define TICKS_PER_REV (MAX_POS / TICK_INCR)
+#define CLOCK_PULSE_MS 30     // coil pulse of the original demo sketch, known to be safe
+#define CLOCK_INTERVAL_MS 40  // pause between ticks of the original demo sketch
+#define CLOCK_MIN_PULSE_MS 2  // shortest pulse calibration tries
+#define CLOCK_MIN_INTERVAL_MS 0
+#define CLOCK_CAL_MARGIN 25   // percent added to the shortest timing that still advanced reliably
 
+class ClockDial;
+
+/// @brief Asked by ClockDial::calibrate after each trial move whether the hands landed on
+/// position expectedPos, by a position sensor or by asking the user. When it returns false
+/// the hands must be back on expectedPos before it returns (set by hand, or ticked on to a
+/// sensor index), since calibration carries on from there.
+typedef bool (*ClockDialCheck)(ClockDial &dial, int expectedPos);
+
+/// @brief Dial driven by a clock mechanism, which only moves forward one tick at a time.
+/// The physical position of the hands is kept in ticks, so a new target set while a move
+/// is under way takes over at once from wherever the hands are.
 class ClockDial
 {
 public:
     ClockDial() {}
-    void init(int clockA=0, int clockB=0, Adafruit_PWMServoDriver *pwm=nullptr, int prevPos = 0);
+    void init(int clockA=0, int clockB=0, PwmBank *pwm=nullptr, int prevPos = 0);
     void setPos(int desPos);
     bool moveOneStep();
     int getPos();
+    int getTicksToGo();
+    void setTiming(int pulseMs, int intervalMs);
+    int getPulseMs();
+    int getIntervalMs();
+    bool calibrate(ClockDialCheck check, int marginPercent = CLOCK_CAL_MARGIN);
+    bool loadTiming();
+    void saveTiming();
     void print();
 
 private:
     void pwm_digitalWrite(int pin, int value);
     inline void doTick();
-    int des_pos_to_val(int desPos);
+    int des_pos_to_tick(int desPos);
     void set_des_pos(int d);
+    bool trialMove(ClockDialCheck check);
+    int search(int *timing, int lo, int hi, ClockDialCheck check);
     int _clockA; // wire 1 connected to the clock
     int _clockB; // wire 2 connected to the clock (order doesn't matter)
-    Adafruit_PWMServoDriver *_pwm;
-    unsigned long _prevPos;
-    unsigned long _currPos;
-    int _sv; // set value
+    PwmBank *_pwm;
+    unsigned long _prevPos; // last position asked for
+    volatile int _currTick; // where the hands physically are, 0 <= _currTick < TICKS_PER_REV
+    volatile int _sv;       // set value, the tick the hands are moving to
     int _tickPin;     // keeps track of which clock pin should be fired next
+    int _pulseMs = CLOCK_PULSE_MS;       // how long the coil is energized per tick
+    int _intervalMs = CLOCK_INTERVAL_MS; // pause before each tick
     int _d;
 };
 
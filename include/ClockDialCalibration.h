@@ -0,0 +1,23 @@
+/*
+Calibration of a ClockDial with the user watching the hands
+*/
+
+#ifndef _CLOCK_DIAL_CALIBRATION_H
+#define _CLOCK_DIAL_CALIBRATION_H
+
+#include "PwmBank.h"
+
+class ClockDial;
+
+/// @brief ClockDialCheck that asks the user on the M5StickC: button A when the hands
+/// landed on expectedPos, button B when they did not. After B the user sets the hands on
+/// expectedPos by hand and presses A.
+bool confirmWithButtons(ClockDial &dial, int expectedPos);
+
+/// @brief Calibrates the clock mechanism on PWM channels clockA and clockB with
+/// confirmWithButtons and saves the timing with ClockDial::saveTiming(), so every
+/// ClockDial on these channels loads it in init(). Blocks until the user is done.
+/// @return false if the mechanism misses ticks even with the demo timing
+bool calibrateClockDial(PwmBank &pwm, int clockA, int clockB);
+
+#endif
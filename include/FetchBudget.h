@@ -0,0 +1,80 @@
+/*
+Deadline bounded network I/O for the score poll
+*/
+
+#ifndef _FETCH_BUDGET_H
+#define _FETCH_BUDGET_H
+
+#include <WiFiClientSecure.h>
+
+#define FETCH_BUDGET_MS 15000 // overall time allowed for one poll
+// Share of the overall budget (in percent) given to each phase of the poll
+#define FETCH_SHARE_CONNECT 20
+#define FETCH_SHARE_TLS 30
+#define FETCH_SHARE_HEADERS 15
+#define FETCH_SHARE_BODY 35
+#define FETCH_MAX_LINE_LEN 2048 // longest line kept by ScoreFetcher, the rest is dropped
+
+enum class FetchPhase
+{
+    Connect,
+    Tls,
+    Headers,
+    Body,
+    Count
+};
+
+enum class FetchError
+{
+    None,
+    ConnectFailed,
+    ConnectTimeout,
+    TlsTimeout,
+    HeaderTimeout,
+    BodyTimeout,
+    Closed,
+    Cancelled,
+    ByteLimit
+};
+
+const char *fetchErrorName(FetchError error);
+
+/// @brief Time budget for one poll, split across connect, TLS, headers and body.
+/// Every blocking step checks the deadline of the current phase and the overall
+/// deadline, and records a typed error once either runs out or the poll is cancelled.
+class FetchBudget
+{
+public:
+    FetchBudget(unsigned long totalMs = FETCH_BUDGET_MS);
+    void startPhase(FetchPhase phase);
+    FetchPhase getPhase();
+    unsigned long phaseRemaining();
+    unsigned long elapsed();
+    bool expired();
+    void cancel();
+    bool isCancelled();
+    void fail(FetchError error);
+    FetchError getError();
+    bool ok();
+
+    bool connect(WiFiClientSecure &client, const char *host, uint16_t port);
+    bool connect(WiFiClient &client, const char *host, uint16_t port);
+    FetchError readLine(Client &client, char *line, size_t size);
+    void setByteLimit(unsigned long limit);
+    unsigned long bytesRead();
+
+private:
+    unsigned long phaseShare(FetchPhase phase);
+    FetchError timeoutError();
+    unsigned long _start;
+    unsigned long _total;
+    unsigned long _phaseStart;
+    unsigned long _phaseDeadline; // relative to _start
+    FetchPhase _phase;
+    FetchError _error;
+    volatile bool _cancelled;
+    unsigned long _bytesRead;
+    unsigned long _byteLimit; // 0 for no limit
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+Hedged score requests across a primary and a backup source
+*/
+
+#ifndef _HEDGED_FETCH_H
+#define _HEDGED_FETCH_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+#include "ScoreFetcher.h"
+
+#define HEDGE_LATENCY_SAMPLES 20  // recent primary latencies kept for the percentile
+#define HEDGE_MIN_SAMPLES 5       // below this the default delay is used
+#define HEDGE_DEFAULT_DELAY 3000  // ms before hedging while there is no latency history
+#define HEDGE_MIN_DELAY 200       // never hedge sooner than this
+#define HEDGE_WORKER_STACK 12288  // a TLS handshake needs a large stack
+
+struct HedgeWorker
+{
+    ScoreFetcher *fetcher;
+    char path[SCORECARD_PATH_LEN];
+    FetchBudget budget;
+    MatchDetails details;
+    volatile bool running;
+    bool ok;
+    unsigned long latency;
+    EventGroupHandle_t events;
+    EventBits_t doneBit;
+};
+
+/// @brief Sends the request to the primary source and, if it has not answered within a
+/// percentile of its recent latency, a second request to the backup source. The first
+/// valid score wins and the other request is cancelled.
+/// Both requests run on their own FreeRTOS task; the caller blocks until there is a
+/// winner or both failed. A cancelled request finishes in the background and its
+/// worker is only reused once it has stopped. Until then nothing on the calling task
+/// touches that fetcher: its source is not changed and its state is not printed.
+class HedgedFetch
+{
+public:
+    HedgedFetch(ScoreFetcher &primary, ScoreFetcher &backup);
+    void setSources(const char *primaryHost, uint16_t primaryPort, const char *backupHost, uint16_t backupPort);
+    void setPercentile(int percentile);
+    unsigned long hedgeDelay();
+    bool fetch(const char *path, MatchDetails &details);
+    bool isBusy(int index);
+    unsigned long getPolls();
+    unsigned long getHedges();
+    unsigned long getWins(int index);
+    unsigned long getFailures();
+    void print();
+
+private:
+    static void workerTask(void *arg);
+    bool start(int index, const char *path);
+    void recordLatency(unsigned long latency);
+    ScoreFetcher *_fetchers[2];
+    HedgeWorker _workers[2];
+    EventGroupHandle_t _events = nullptr;
+    int _percentile = 90;
+    unsigned long _latencies[HEDGE_LATENCY_SAMPLES];
+    size_t _latencyNext = 0;
+    size_t _latencyCount = 0;
+    unsigned long _polls = 0;
+    unsigned long _hedges = 0;
+    unsigned long _wins[2] = {0, 0};
+    unsigned long _failures = 0;
+};
+
+#endif
@@ -0,0 +1,55 @@
+/*
+Optional tracing of the PCA9685 I2C transactions
+*/
+
+#ifndef _I2C_TRACE_H
+#define _I2C_TRACE_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+#define I2C_TRACE_LEN 256        // records kept, the oldest are overwritten
+#define PCA9685_SETPWM_BYTES 6   // address, register and 4 data bytes per setPWM
+
+struct I2CTraceRecord
+{
+    uint32_t startUs;    // micros() when the transaction started
+    uint32_t durationUs; // time spent in the driver call
+    uint8_t channel;     // PwmBank channel
+    uint8_t bus;         // 0 for Wire, 1 for Wire1
+    uint8_t bytes;       // bytes put on the bus, 0 for an interrupts-off window without bus traffic
+    bool irqOff;         // interrupts were disabled for the whole duration
+};
+
+/// @brief Ring buffer of I2C transactions, exported as CSV for tools/i2c_replay.cpp.
+/// Only compiled in when _I2C_TRACE_ is defined (see the m5stick-c-trace environment).
+class I2CTrace
+{
+public:
+    I2CTrace() {}
+    void record(uint32_t startUs, uint32_t durationUs, uint8_t channel, uint8_t bytes, bool irqOff, uint8_t bus = 0);
+    size_t count();
+    unsigned long getTotal();
+    void clear();
+    void exportCsv(Print &out);
+
+private:
+    I2CTraceRecord _records[I2C_TRACE_LEN];
+    size_t _next = 0;
+    unsigned long _total = 0;
+    portMUX_TYPE _lock = portMUX_INITIALIZER_UNLOCKED; // both buses record at the same time
+};
+
+#ifdef _I2C_TRACE_
+extern I2CTrace i2cTrace;
+// Wrap a driver call: I2C_TRACE_BEGIN(); _pwm->setPWM(...); I2C_TRACE_END(channel, bytes, irqOff);
+#define I2C_TRACE_BEGIN() uint32_t _i2cTraceStart = micros()
+#define I2C_TRACE_END(channel, bytes, irqOff) i2cTrace.record(_i2cTraceStart, micros() - _i2cTraceStart, channel, bytes, irqOff)
+#define I2C_TRACE_END_BUS(bus, channel, bytes, irqOff) i2cTrace.record(_i2cTraceStart, micros() - _i2cTraceStart, channel, bytes, irqOff, bus)
+#else
+#define I2C_TRACE_BEGIN()
+#define I2C_TRACE_END(channel, bytes, irqOff)
+#define I2C_TRACE_END_BUS(bus, channel, bytes, irqOff)
+#endif
+
+#endif
@@ -2,6 +2,7 @@
 #define _MATCH_DETAILS_H
 
 #include <WiFiClientSecure.h>
+#include "FetchBudget.h"
 
 #ifdef _DEBUG_
 #define _PP(a) Serial.print(a);
@@ -17,6 +18,7 @@ class MatchDetails
   int wickets;
   int overs;
   bool initialized;
+  uint32_t fingerprint; // of the description line the score was parsed from
 
   int runDigits[3];
   int wicketDigits[2];
@@ -32,11 +34,12 @@ class MatchDetails
     int getWickets();
     int getOvers();
     bool isInitialized();
+    uint32_t getFingerprint();
     int *getRunDigits();
     int *getWicketDigits();
     int *getOverDigits();
     void print();
-    MatchDetails *getMatchDetails(WiFiClientSecure &client);
+    MatchDetails *getMatchDetails(Client &client, FetchBudget &budget, char *line, size_t size, const MatchDetails *known = nullptr);
 
 };
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+/*
+Heap and stack telemetry
+*/
+
+#ifndef _MEMORY_TELEMETRY_H
+#define _MEMORY_TELEMETRY_H
+
+#include <Arduino.h>
+
+#define TELEMETRY_PERIOD 60000        // one time-series sample per minute
+#define TELEMETRY_SAMPLES 60          // keep the last hour
+#define TELEMETRY_MAX_TASKS 8         // scheduler tasks tracked
+#define TELEMETRY_LEAK_MIN_SAMPLES 30 // samples needed before judging the trend
+#define TELEMETRY_LEAK_SLOPE 1024     // free heap falling faster than this many bytes per hour is a leak
+
+struct MemorySample
+{
+    uint32_t millis;
+    uint32_t freeHeap;
+    uint32_t minFreeHeap;  // lowest free heap since boot
+    uint32_t largestBlock; // largest block that can be allocated
+    uint32_t stackFree;    // high-water mark of the loop task stack, in bytes
+};
+
+struct TaskStackMark
+{
+    const char *name;
+    uint32_t stackFree;    // loop task stack high-water mark seen right after this task ran
+    uint32_t minFreeHeap;  // lowest free heap seen right after this task ran
+    int32_t heapDelta;      // free heap after minus before, summed over all runs
+    int32_t worstHeapDelta; // the run that left the least free heap behind
+    unsigned long runs;
+    unsigned long runsReported; // runs at the last printTaskRuns()
+    unsigned long stackDrops; // runs that pushed the stack high-water mark deeper
+};
+
+/// @brief Samples free heap, minimum free heap, largest free block and stack high-water marks.
+/// All TaskScheduler callbacks run on the Arduino loop task through runTask(), so the
+/// per-task stack figure is the loop task's high-water mark right after the callback,
+/// a callback that deepens it is counted against that task, and the free heap before
+/// and after every run gives the heap each task keeps.
+class MemoryTelemetry
+{
+public:
+    MemoryTelemetry() {}
+    void sample();
+    void runTask(const char *name, void (*callback)());
+    float heapSlope();
+    bool leakSuspected();
+    void exportJson(String &out);
+    void print();
+    void printTaskRuns();
+
+private:
+    MemorySample takeSample();
+    TaskStackMark *findTask(const char *name);
+    MemorySample _samples[TELEMETRY_SAMPLES];
+    size_t _next = 0;
+    size_t _count = 0;
+    TaskStackMark _tasks[TELEMETRY_MAX_TASKS];
+    size_t _taskCount = 0;
+    uint32_t _stackFree = UINT32_MAX;
+    bool _leakReported = false;
+};
+
+#endif
@@ -0,0 +1,56 @@
+/*
+Board side of the scoreproxy protocol
+*/
+
+#ifndef _PROXY_CLIENT_H
+#define _PROXY_CLIENT_H
+
+#include <WiFiUdp.h>
+#include "MatchDetails.h"
+#include "ProxyFrame.h"
+
+#define PROXY_TIMEOUT 1500        // ms to wait for a reply
+#define PROXY_ATTEMPTS 2          // requests sent before giving up on the proxy for this poll
+#define PROXY_MAX_AGE 180         // s, an older score means the proxy's scrapes are failing
+#define PROXY_BACKOFF_AFTER 2     // polls in a row without an answer before the proxy is skipped
+#define PROXY_BACKOFF_BASE 60000  // ms the proxy is skipped for at first, doubled on every further miss
+#define PROXY_BACKOFF_MAX 900000  // longest the proxy is skipped
+
+/// @brief Asks a scoreproxy on the LAN for the score instead of fetching the scorecard.
+/// The proxy only sends the fields that changed since the sequence number the board
+/// already has, so a poll is a few bytes each way and no TLS runs on the board.
+/// A score the proxy last scraped more than PROXY_MAX_AGE ago is not used, and a proxy
+/// that stopped answering is skipped for a growing time instead of blocking every poll
+/// for PROXY_ATTEMPTS * PROXY_TIMEOUT; in both cases the caller fetches directly.
+class ProxyClient
+{
+public:
+    ProxyClient() {}
+    void setProxy(const char *host, uint16_t port = PROXY_PORT);
+    bool isConfigured();
+    bool fetch(const char *tournament, uint32_t matchId, uint32_t clubId, MatchDetails &details);
+    void print();
+
+private:
+    void reset(uint32_t matchId, uint32_t clubId);
+    void backOff();
+    WiFiUDP _udp;
+    bool _started = false;
+    char _host[64] = "";
+    uint16_t _port = PROXY_PORT;
+    uint32_t _matchId = 0;
+    uint32_t _clubId = 0;
+    ProxyReply _score = {}; // score and seq the board has, deltas are applied onto it
+    bool _haveScore = false;
+    unsigned long _polls = 0;
+    unsigned long _unchanged = 0;
+    unsigned long _failures = 0;
+    unsigned long _missedInRow = 0; // polls in a row the proxy did not answer
+    unsigned long _retryAt = 0;     // while backing off, millis() of the next poll that asks the proxy
+    unsigned long _skipped = 0;
+    unsigned long _stale = 0;
+    unsigned long _bytesIn = 0;
+    unsigned long _bytesOut = 0;
+};
+
+#endif
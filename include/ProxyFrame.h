@@ -0,0 +1,81 @@
+/*
+Binary protocol between the boards and the scoreproxy daemon
+*/
+
+#ifndef _PROXY_FRAME_H
+#define _PROXY_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Shared by ProxyClient on the board and tools/scoreproxy.cpp on the host, so it
+// only depends on the C library. All fields are big endian, sent over UDP.
+//
+// Request, board -> proxy, 19 bytes + tournament:
+//   0  magic 'S' 'P'
+//   2  version
+//   3  PROXY_REQUEST
+//   4  epoch     - proxy epoch the board's seq belongs to, 0 if it has none
+//   6  seq       - sequence number of the score the board already has, 0 if none
+//   10 matchId
+//   14 clubId
+//   18 tournament length, then the tournament id (at most PROXY_TOURNAMENT_LEN bytes)
+//
+// Reply, proxy -> board, 13 bytes + changed fields:
+//   0  magic 'S' 'P'
+//   2  version
+//   3  PROXY_REPLY
+//   4  epoch     - random per proxy start
+//   6  seq       - sequence number of the proxy's current score, 0 while it has none
+//   10 mask      - which fields follow, changed since the board's seq (all of them when the
+//                  proxy no longer knows that seq): PROXY_RUNS u16, PROXY_OVERS u16, PROXY_WICKETS u8
+//   11 age       - seconds since the proxy last scraped the score successfully, capped at 65535
+#define PROXY_MAGIC0 'S'
+#define PROXY_MAGIC1 'P'
+#define PROXY_VERSION 2
+#define PROXY_PORT 8367
+#define PROXY_TOURNAMENT_LEN 32
+#define PROXY_REQUEST_MAX_LEN (19 + PROXY_TOURNAMENT_LEN)
+#define PROXY_REPLY_HEADER_LEN 13
+#define PROXY_REPLY_MAX_LEN (PROXY_REPLY_HEADER_LEN + 5)
+
+enum ProxyFrameType
+{
+    PROXY_REQUEST = 1,
+    PROXY_REPLY = 2
+};
+
+enum ProxyField
+{
+    PROXY_RUNS = 1,
+    PROXY_OVERS = 2,
+    PROXY_WICKETS = 4,
+    PROXY_ALL = 7
+};
+
+struct ProxyRequest
+{
+    uint16_t epoch;
+    uint32_t seq;
+    uint32_t matchId;
+    uint32_t clubId;
+    char tournament[PROXY_TOURNAMENT_LEN + 1];
+};
+
+struct ProxyReply
+{
+    uint16_t epoch;
+    uint32_t seq;
+    uint8_t mask;
+    uint16_t age;
+    uint16_t runs;
+    uint16_t overs;
+    uint8_t wickets;
+};
+
+size_t encodeProxyRequest(const ProxyRequest &request, uint8_t *buf, size_t len);
+bool decodeProxyRequest(const uint8_t *buf, size_t len, ProxyRequest &request);
+size_t encodeProxyReply(const ProxyReply &reply, uint8_t *buf, size_t len);
+bool decodeProxyReply(const uint8_t *buf, size_t len, ProxyReply &reply);
+
+#endif
@@ -0,0 +1,81 @@
+/*
+Several PCA9685 boards on both ESP32 I2C controllers, seen as one row of channels
+*/
+
+#ifndef _PWM_BANK_H
+#define _PWM_BANK_H
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <Adafruit_PWMServoDriver.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/event_groups.h>
+
+#define PWM_BANK_MAX_BUSES 2           // Wire and Wire1
+#define PWM_BANK_MAX_BOARDS 16
+#define PCA9685_CHANNELS 16
+#define PCA9685_FIRST_ADDR 0x40
+#define PCA9685_ADDRS 8                // 0x40 - 0x47 are searched on every bus
+#define PCA9685_LED0_ON_L 0x06         // first channel register, 4 per channel
+#define PWM_BUS_TASK_STACK 2048
+
+// Define _PWM_WIRE1_ to add the second controller as M5.begin() started it. On the
+// M5StickC that is the internal bus on pins 21/22, shared with the AXP192 (0x34), the
+// BM8563 RTC (0x51) and the IMU (0x68), none of them in 0x40-0x47 or at the PCA9685
+// all-call address 0x70. The ESP32 Wire driver locks the bus per transaction, so the bus
+// task and the M5 library can both use it. Wire1 is not moved to other pins, that would
+// cut the PMIC off.
+
+struct PwmBoard
+{
+    Adafruit_PWMServoDriver *driver;
+    uint8_t bus;
+    uint8_t addr;
+    uint16_t dirty; // channels with a write waiting for flush()
+    uint16_t on[PCA9685_CHANNELS];
+    uint16_t off[PCA9685_CHANNELS];
+};
+
+class PwmBank;
+
+struct PwmBus
+{
+    PwmBank *bank;
+    int index;
+    TwoWire *wire;
+};
+
+/// @brief Finds the PCA9685 boards on the added buses and numbers their channels one
+/// after the other, board 0 channels 0-15, board 1 channels 16-31 and so on. Boards are
+/// taken by address, alternating between the buses, so a growing row of dials is spread
+/// over both of them and the first board is still the one at 0x40 on Wire.
+/// setPWM() only queues a write. flush() writes each run of changed channels of a board
+/// in one auto increment transaction, the buses in parallel: the first on the calling
+/// task, the others on their own FreeRTOS task.
+class PwmBank
+{
+public:
+    PwmBank() {}
+    void addBus(TwoWire &wire);
+    int begin(float freq);
+    int getChannelCount();
+    void setPWM(int channel, uint16_t on, uint16_t off);
+    void flush();
+    void print();
+
+private:
+    static void busTask(void *arg);
+    bool probe(TwoWire &wire, uint8_t addr);
+    void writeBus(int bus);
+    PwmBus _buses[PWM_BANK_MAX_BUSES];
+    int _busCount = 0;
+    PwmBoard _boards[PWM_BANK_MAX_BOARDS];
+    int _boardCount = 0;
+    EventGroupHandle_t _events = nullptr; // bit i starts bus i, bit i + 8 tells it is done
+    unsigned long _flushes = 0;
+    unsigned long _transactions = 0;
+    unsigned long _lastFlushUs = 0;
+    unsigned long _maxFlushUs = 0;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+Leader / follower score sharing over UDP multicast
+*/
+
+#ifndef _SCORE_BROADCAST_H
+#define _SCORE_BROADCAST_H
+
+#include "MatchDetails.h"
+#include "ScoreFrame.h"
+#include "ScoreTransport.h"
+#define SCORE_STALE_PERIOD 90000 // follower asks for the score if nothing was heard for 1.5 poll periods
+#define SCORE_REQUEST_RETRY 5000 // minimum time between two requests of a follower
+
+enum BoardRole
+{
+    ROLE_STANDALONE, // fetches the score itself, shares nothing
+    ROLE_LEADER,     // fetches the score and multicasts it
+    ROLE_FOLLOWER    // never fetches, shows what the leader multicasts
+};
+
+BoardRole boardRoleFromName(const char *name);
+
+/// @brief One leader fetches the score and multicasts a small sequence numbered frame.
+/// Followers apply every frame they receive. Frames carry the whole score, so a missed
+/// frame is repaired by the next one; if the leader goes quiet the follower asks it
+/// (or the group, before a leader is known) for the current score by unicast.
+class ScoreBroadcast
+{
+public:
+    ScoreBroadcast(ScoreTransport &transport) : _transport(transport) {}
+    bool begin(BoardRole role, uint32_t matchId);
+    BoardRole getRole();
+    uint32_t getMatchId();
+    void publish(MatchDetails &details);
+    bool poll(MatchDetails &details);
+    unsigned long getFramesReceived();
+    unsigned long getFramesMissed();
+    unsigned long getRequestsAnswered();
+    void print();
+
+private:
+    void send(const ScorePeer &to, ScoreFrame &frame);
+    void sendRequest();
+    ScoreTransport &_transport;
+    BoardRole _role = ROLE_STANDALONE;
+    bool _started = false;
+    uint32_t _matchId = 0;
+    ScoreFrame _last = {};   // leader: last published frame, follower: last applied frame
+    bool _haveLast = false;
+    ScorePeer _leader = {}; // port 0 until a leader was heard: requests go to the group
+    unsigned long _lastHeard = 0;
+    unsigned long _lastRequest = 0;
+    bool _askNow = false; // a follower that just started asks right away
+    unsigned long _framesReceived = 0;
+    unsigned long _framesMissed = 0;
+    unsigned long _requestsSent = 0;
+    unsigned long _requestsAnswered = 0;
+};
+
+#endif
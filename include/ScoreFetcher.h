@@ -0,0 +1,67 @@
+/*
+Fetches the score from one scorecard source
+*/
+
+#ifndef _SCORE_FETCHER_H
+#define _SCORE_FETCHER_H
+
+#include <WiFiClientSecure.h>
+#include "FetchBudget.h"
+#include "MatchDetails.h"
+
+#define SOURCE_HOST_LEN 64
+#define SCORECARD_PATH_LEN 128
+#define VALIDATOR_LEN 80 // longest ETag / Last-Modified remembered, longer ones are not used
+#define SCORE_TAG_MARGIN 2048 // bytes around the learned description line that are still fetched
+
+enum class RangeSupport
+{
+    Unknown,
+    Yes,
+    No
+};
+
+/// @brief One scorecard source, e.g. cricclubs.com, a mirror or a local relay.
+/// Port 443 is fetched over TLS, any other port over plain HTTP.
+/// The last page's validators and score are kept, so an unchanged scorecard is a
+/// 304 without a body, or, from a source without validators, is recognised by the
+/// fingerprint of its description line without parsing it again.
+/// Where the description line sits in the page is learned too: later polls ask for
+/// just that byte range, or, when the source ignores Range, give up once the page
+/// runs past it, instead of reading the whole page.
+class ScoreFetcher
+{
+public:
+    ScoreFetcher() {}
+    void setSource(const char *host, uint16_t port = 443);
+    bool isSource(const char *host, uint16_t port);
+    const char *getHost();
+    bool isConfigured();
+    bool fetch(const char *path, FetchBudget &budget, MatchDetails &details);
+    unsigned long getNotModified();
+    unsigned long getSameFingerprint();
+    void print();
+
+private:
+    bool request(Client &client, const char *path, FetchBudget &budget, MatchDetails &details);
+    void forgetPage();
+    char _host[SOURCE_HOST_LEN] = "";
+    char _line[FETCH_MAX_LINE_LEN + 1]; // statically sized so a poll does no String churn
+    uint16_t _port = 443;
+    char _cachedPath[SCORECARD_PATH_LEN] = ""; // page the validators and score below belong to
+    char _etag[VALIDATOR_LEN] = "";
+    char _lastModified[VALIDATOR_LEN] = "";
+    MatchDetails _cached;
+    unsigned long _requests = 0;
+    unsigned long _notModified = 0;
+    unsigned long _sameFingerprint = 0;
+    unsigned long _tagStart = 0; // body offsets of the description line, 0 until learned
+    unsigned long _tagEnd = 0;
+    unsigned long _pageSize = 0; // body size of the full page, 0 until known
+    RangeSupport _range = RangeSupport::Unknown;
+    unsigned long _bytesDownloaded = 0;
+    unsigned long _bytesFullPage = 0; // what the same polls would have cost reading whole pages
+    unsigned long _earlyCloses = 0;
+};
+
+#endif
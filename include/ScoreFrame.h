@@ -0,0 +1,48 @@
+/*
+Compact binary score frame shared between boards
+*/
+
+#ifndef _SCORE_FRAME_H
+#define _SCORE_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// The frame only depends on the C library so it can be encoded and decoded on the host as well.
+//
+// Layout (big endian), 19 bytes:
+//   0  magic 'S' 'B'
+//   2  version
+//   3  type (ScoreFrameType)
+//   4  epoch     - random per leader boot, lets followers accept a restarted leader's sequence numbers
+//   6  seq       - incremented by the leader every time the score changes
+//   10 matchId
+//   14 runs
+//   16 overs
+//   18 wickets
+#define SCORE_FRAME_MAGIC0 'S'
+#define SCORE_FRAME_MAGIC1 'B'
+#define SCORE_FRAME_VERSION 1
+#define SCORE_FRAME_LEN 19
+
+enum ScoreFrameType
+{
+    FRAME_SCORE = 1,  // current score, multicast by the leader or sent in reply to a request
+    FRAME_REQUEST = 2 // follower asking for the current score
+};
+
+struct ScoreFrame
+{
+    uint8_t type;
+    uint16_t epoch;
+    uint32_t seq;
+    uint32_t matchId;
+    uint16_t runs;
+    uint16_t overs;
+    uint8_t wickets;
+};
+
+size_t encodeScoreFrame(const ScoreFrame &frame, uint8_t *buf, size_t len);
+bool decodeScoreFrame(const uint8_t *buf, size_t len, ScoreFrame &frame);
+
+#endif
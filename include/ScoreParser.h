@@ -0,0 +1,21 @@
+/*
+Extracts the score from a scorecard page line
+*/
+
+#ifndef _SCORE_PARSER_H
+#define _SCORE_PARSER_H
+
+// Shared by MatchDetails on the board and tools/scoreproxy.cpp on the host,
+// so it only depends on the C library.
+
+struct ParsedScore
+{
+    int runs;
+    int wickets;
+    int overs;
+};
+
+bool isScoreLine(const char *line);
+bool parseScoreLine(const char *line, ParsedScore &score);
+
+#endif
@@ -0,0 +1,32 @@
+/*
+Datagram transport under score sharing
+*/
+
+#ifndef _SCORE_TRANSPORT_H
+#define _SCORE_TRANSPORT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+/// @brief Where a datagram came from or goes to. Port 0 stands for the score group.
+struct ScorePeer
+{
+    uint32_t ip;
+    uint16_t port;
+};
+
+/// @brief What ScoreBroadcast needs from the network: join the score group, send to
+/// the group or to one board, and receive without blocking. UdpScoreTransport runs it
+/// over WiFiUDP multicast; the host tests connect several boards in memory.
+class ScoreTransport
+{
+public:
+    virtual ~ScoreTransport() {}
+    virtual bool join() = 0;
+    virtual void leave() = 0;
+    virtual bool send(const ScorePeer &to, const uint8_t *buf, size_t len) = 0;
+    /// @return the length of the next datagram, 0 when there is none
+    virtual int receive(uint8_t *buf, size_t size, ScorePeer &from) = 0;
+};
+
+#endif
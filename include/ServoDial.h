@@ -6,7 +6,7 @@ Class to control Dial
 #define _SERVO_DIAL_H
 
 #include <M5StickC.h>
-#include <Adafruit_PWMServoDriver.h>
+#include "PwmBank.h"
 
 #define MIN_POS 0
 #define MAX_POS 10
@@ -18,7 +18,7 @@ class ServoDial
 {
 public:
     ServoDial() {}
-    void init(int servoConnection, Adafruit_PWMServoDriver *pwm=nullptr, int prevPos = 0);
+    void init(int servoConnection, PwmBank *pwm=nullptr, int prevPos = 0);
     void setPos(int desPos);
     int getPos();
     void print();
@@ -26,7 +26,7 @@ public:
 private:
     int des_pos_to_val(int desPos);
     void set_des_pos(int d);
-    Adafruit_PWMServoDriver *_pwm;
+    PwmBank *_pwm;
     int _servoConnection;
     int _currPos;
 };
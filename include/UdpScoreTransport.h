@@ -0,0 +1,27 @@
+/*
+Score sharing over WiFiUDP multicast
+*/
+
+#ifndef _UDP_SCORE_TRANSPORT_H
+#define _UDP_SCORE_TRANSPORT_H
+
+#include <WiFiUdp.h>
+#include "ScoreTransport.h"
+
+#define SCORE_GROUP_IP IPAddress(239, 255, 83, 66)
+#define SCORE_GROUP_PORT 8366
+
+class UdpScoreTransport : public ScoreTransport
+{
+public:
+    UdpScoreTransport() {}
+    bool join() override;
+    void leave() override;
+    bool send(const ScorePeer &to, const uint8_t *buf, size_t len) override;
+    int receive(uint8_t *buf, size_t size, ScorePeer &from) override;
+
+private:
+    WiFiUDP _udp;
+};
+
+#endif
@@ -0,0 +1,76 @@
+// Boot State
+//
+// After a brownout or watchdog reset the board should show the score again before
+// WiFi and the config portal are up. The dial positions and the last score are
+// mirrored into RTC slow memory every time the dials move, and restored by setup().
+// A power-on reset leaves RTC memory undefined, so the snapshot is then ignored.
+
+#include <esp_system.h>
+#include "BootState.h"
+
+RTC_NOINIT_ATTR static BootSnapshot rtcSnapshot;
+
+static uint32_t snapshotChecksum(const BootSnapshot &snapshot)
+{
+    // FNV-1a over everything before the checksum
+    const uint8_t *p = (const uint8_t *)&snapshot;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < offsetof(BootSnapshot, checksum); i++)
+    {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static bool snapshotValid()
+{
+    return rtcSnapshot.magic == BOOT_STATE_MAGIC && rtcSnapshot.dialCount <= BOOT_STATE_MAX_DIALS && rtcSnapshot.checksum == snapshotChecksum(rtcSnapshot);
+}
+
+/// @brief Returns the snapshot written before the last reset.
+/// @return false after a power-on reset or when RTC memory does not hold a valid snapshot
+bool restoreBootSnapshot(BootSnapshot &snapshot)
+{
+    if (esp_reset_reason() == ESP_RST_POWERON || !snapshotValid())
+    {
+        memset(&rtcSnapshot, 0, sizeof(rtcSnapshot));
+        return false;
+    }
+    rtcSnapshot.bootCount++;
+    rtcSnapshot.checksum = snapshotChecksum(rtcSnapshot);
+    snapshot = rtcSnapshot;
+    return true;
+}
+
+void saveBootSnapshot(const int *dialPos, int dialCount, int runs, int overs, int wickets)
+{
+    if (!snapshotValid())
+    {
+        memset(&rtcSnapshot, 0, sizeof(rtcSnapshot));
+        rtcSnapshot.magic = BOOT_STATE_MAGIC;
+    }
+    rtcSnapshot.dialCount = dialCount < BOOT_STATE_MAX_DIALS ? dialCount : BOOT_STATE_MAX_DIALS;
+    for (int i = 0; i < rtcSnapshot.dialCount; i++)
+    {
+        rtcSnapshot.dialPos[i] = dialPos[i];
+    }
+    rtcSnapshot.runs = runs;
+    rtcSnapshot.overs = overs;
+    rtcSnapshot.wickets = wickets;
+    rtcSnapshot.checksum = snapshotChecksum(rtcSnapshot);
+}
+
+void saveBootToScore(unsigned long ms)
+{
+    if (snapshotValid())
+    {
+        rtcSnapshot.lastBootToScoreMs = ms;
+        rtcSnapshot.checksum = snapshotChecksum(rtcSnapshot);
+    }
+}
+
+/// @brief Drops the snapshot, so a reset before the next save falls back to the saved config
+void invalidateBootSnapshot()
+{
+    memset(&rtcSnapshot, 0, sizeof(rtcSnapshot));
+}
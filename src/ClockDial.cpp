@@ -17,16 +17,23 @@
 // to be called each time you want the clock to tick.
 //
 
+// The pulse width and the pause between ticks of the demo sketch are far longer than
+// most mechanisms need. calibrate() searches for the shortest ones that still advance
+// the hands reliably, and the result is kept in NVS per dial.
+
+#include <Preferences.h>
 #include "ClockDial.h"
+#include "I2CTrace.h"
 
-void ClockDial::init(int clockA, int clockB, Adafruit_PWMServoDriver *pwm, int prevPos)
+void ClockDial::init(int clockA, int clockB, PwmBank *pwm, int prevPos)
 {
     _clockA = clockA;
     _clockB = clockB;
     _pwm = pwm;
     _prevPos = prevPos;
-    _currPos = des_pos_to_val(prevPos);
-    _sv = _currPos;
+    // the hands are assumed to be where the previous run left them
+    _currTick = des_pos_to_tick(prevPos);
+    _sv = _currTick;
     _tickPin = clockA;
     Serial.println("Setting pinMode:");
     // For some unknown reason, if the below is done for any other value the program crashes
@@ -35,42 +42,43 @@ void ClockDial::init(int clockA, int clockB, Adafruit_PWMServoDriver *pwm, int p
         pinMode(_clockA, OUTPUT);
         pinMode(_clockB, OUTPUT);
     }
+    loadTiming();
 
     Serial.println("Dial init:");
     this->print();
 }
 
-int ClockDial::des_pos_to_val(int desPos)
+/// @brief Tick of the hands for position desPos, rounded to the nearest tick since an
+/// item is not a whole number of ticks
+int ClockDial::des_pos_to_tick(int desPos)
 {
-    int scaled_Val = desPos * MIN_POS_INCR;
-    int prev_scaled_Val = _prevPos * MIN_POS_INCR;
-    int d;
+    int tick = (desPos * TICKS_PER_REV + NUM_ITEMS / 2) / NUM_ITEMS;
+    return tick % TICKS_PER_REV;
+}
 
-    if (scaled_Val >= prev_scaled_Val)
-    {
-        d = (scaled_Val - prev_scaled_Val);
-    }
-    else
-    {
-        d = ((MAX_POS) - (prev_scaled_Val - scaled_Val));
-    }
-    Serial.print("New Setting for desPos: ");
-    Serial.print(desPos);
-    Serial.printf("\tprevPos: %ld", _prevPos);
-    Serial.printf("\tscaled_Val: %d", scaled_Val);
-    Serial.printf("\tprev_scaled_Val: %d", prev_scaled_Val);
-    Serial.printf("\tdiff = %d\n", d);
-    return d;
+/// @brief Ticks left in the current move, the forward distance from the hands to the target
+int ClockDial::getTicksToGo()
+{
+    return (_sv - _currTick + TICKS_PER_REV) % TICKS_PER_REV;
 }
 
+/// @brief Retargets the dial. A move still under way is not finished first: the hands
+/// go forward from where they physically are to the new position.
 void ClockDial::setPos(int desPos)
 {
-    int d = this->des_pos_to_val(desPos);
+    int tick = this->des_pos_to_tick(desPos);
+    Serial.print("New Setting for desPos: ");
+    Serial.print(desPos);
+    Serial.printf("\tprevPos: %ld", _prevPos);
+    Serial.printf("\tcurrTick: %d", _currTick);
+    Serial.printf("\ttarget tick: %d", tick);
+    Serial.printf("\tdiff = %d\n", (tick - _currTick + TICKS_PER_REV) % TICKS_PER_REV);
+    I2C_TRACE_BEGIN();
     cli(); // Interrupt disabled for indivisible processing
     _prevPos = desPos;
-    _currPos = 0;
-    _sv = d; // Set to the target position of the pulse motor
-    sei();   // Interrupt enabled because the setting is completed
+    _sv = tick; // Set to the target position of the pulse motor
+    sei();      // Interrupt enabled because the setting is completed
+    I2C_TRACE_END(_clockA, 0, true);
     Serial.println("Setting Complete");
     this->print();
 }
@@ -82,8 +90,8 @@ int ClockDial::getPos()
 
 void ClockDial::print()
 {
-    Serial.print("Dial: currPos: ");
-    Serial.print(_currPos);
+    Serial.print("Dial: currTick: ");
+    Serial.print(_currTick);
     Serial.print("\t_sv: ");
     Serial.print(_sv);
     Serial.print("\t_prevPos: ");
@@ -94,26 +102,30 @@ void ClockDial::print()
     Serial.print(_clockB);
     Serial.print("\t_tickPin: ");
     Serial.print(_tickPin);
+    Serial.print("\tpulse: ");
+    Serial.print(_pulseMs);
+    Serial.print("\tinterval: ");
+    Serial.print(_intervalMs);
     Serial.print("\n");
 }
 
 bool ClockDial::moveOneStep()
 {
-    if (_currPos < _sv)
+    if (_currTick != _sv)
     {
         this->print();
-        delay(40); // delay(40);
+        delay(_intervalMs);
         this->doTick();
-        _currPos += 10;
+        _currTick = (_currTick + 1) % TICKS_PER_REV;
     }
-    return _currPos < _sv;
+    return _currTick != _sv;
 }
 
 inline void ClockDial::doTick()
 {
     // Energize the electromagnet in the correct direction.
     pwm_digitalWrite(_tickPin, HIGH);
-    delay(30); // delay(10);
+    delay(_pulseMs);
     pwm_digitalWrite(_tickPin, LOW);
 
     // Switch the direction so it will fire in the opposite way next time.
@@ -129,6 +141,7 @@ inline void ClockDial::doTick()
 
 void ClockDial::pwm_digitalWrite(int pin, int val)
 {
+    // the pulse width is timed, so the write goes out at once
     if (val == LOW)
     {
         _pwm->setPWM(pin, 0, 4096);
@@ -137,4 +150,105 @@ void ClockDial::pwm_digitalWrite(int pin, int val)
     {
         _pwm->setPWM(pin, 4096, 0);
     }
-}
\ No newline at end of file
+    _pwm->flush();
+}
+
+void ClockDial::setTiming(int pulseMs, int intervalMs)
+{
+    _pulseMs = pulseMs;
+    _intervalMs = intervalMs;
+}
+
+int ClockDial::getPulseMs()
+{
+    return _pulseMs;
+}
+
+int ClockDial::getIntervalMs()
+{
+    return _intervalMs;
+}
+
+/// @brief Moves the hands on by one position with the current timing and asks check
+/// whether they got there
+bool ClockDial::trialMove(ClockDialCheck check)
+{
+    int next = (_prevPos + 1) % NUM_ITEMS;
+    setPos(next);
+    while (moveOneStep())
+    {
+    }
+    return check(*this, next);
+}
+
+/// @brief Binary search for the shortest *timing in [lo, hi] that passes a trial move,
+/// hi is known to pass
+int ClockDial::search(int *timing, int lo, int hi, ClockDialCheck check)
+{
+    while (hi - lo > 1)
+    {
+        *timing = (lo + hi) / 2;
+        Serial.printf("Trying pulse %d ms, interval %d ms\n", _pulseMs, _intervalMs);
+        if (trialMove(check))
+        {
+            hi = *timing;
+        }
+        else
+        {
+            lo = *timing;
+        }
+    }
+    *timing = hi;
+    return hi;
+}
+
+/// @brief Finds the shortest pulse width, then the shortest pause between ticks, that still
+/// move the hands one position at a time as check confirms, and adds marginPercent to both.
+/// The hands must be on position getPos() and at rest. Call saveTiming() to keep the result.
+/// @return false if even the current timing misses ticks, the timing is then left unchanged
+bool ClockDial::calibrate(ClockDialCheck check, int marginPercent)
+{
+    int pulseMs = _pulseMs;
+    int intervalMs = _intervalMs;
+    if (!trialMove(check))
+    {
+        Serial.println("Dial misses ticks with its current timing, not calibrated");
+        return false;
+    }
+    int pulse = search(&_pulseMs, CLOCK_MIN_PULSE_MS - 1, pulseMs, check);
+    // search the pause with the pulse that will be used
+    _pulseMs = pulse + (pulse * marginPercent + 99) / 100;
+    int interval = search(&_intervalMs, CLOCK_MIN_INTERVAL_MS - 1, intervalMs, check);
+    _intervalMs = interval + (interval * marginPercent + 99) / 100;
+    Serial.printf("Calibrated: pulse %d ms (was %d), interval %d ms (was %d)\n", _pulseMs, pulseMs, _intervalMs, intervalMs);
+    return true;
+}
+
+/// @brief Restores the timing saved by saveTiming() for this dial's pins
+/// @return false if the dial was never calibrated, the timing is then unchanged
+bool ClockDial::loadTiming()
+{
+    Preferences prefs;
+    char key[16];
+    int timing[2];
+    snprintf(key, sizeof(key), "clk%d_%d", _clockA, _clockB);
+    prefs.begin("clockdial", true);
+    bool found = prefs.getBytes(key, timing, sizeof(timing)) == sizeof(timing);
+    prefs.end();
+    if (found)
+    {
+        setTiming(timing[0], timing[1]);
+    }
+    return found;
+}
+
+void ClockDial::saveTiming()
+{
+    Preferences prefs;
+    char key[16];
+    int timing[2] = {_pulseMs, _intervalMs};
+    snprintf(key, sizeof(key), "clk%d_%d", _clockA, _clockB);
+    prefs.begin("clockdial", false);
+    prefs.putBytes(key, timing, sizeof(timing));
+    prefs.end();
+}
@@ -0,0 +1,69 @@
+// Clock Dial Calibration
+//
+// Without a position sensor the user is the one who sees whether a trial move landed,
+// so calibration shows each question on the M5StickC screen and takes the answer from
+// its buttons. It is started from the serial console of the scoreboard.
+
+#include "ClockDial.h"
+#include "ClockDialCalibration.h"
+
+/// @brief Waits for the user to press button A (true) or B (false)
+static bool waitForButton()
+{
+    while (true)
+    {
+        M5.update();
+        if (M5.BtnA.wasPressed())
+        {
+            return true;
+        }
+        if (M5.BtnB.wasPressed())
+        {
+            return false;
+        }
+        delay(10);
+    }
+}
+
+bool confirmWithButtons(ClockDial &dial, int expectedPos)
+{
+    M5.Lcd.fillScreen(BLACK);
+    M5.Lcd.setCursor(0, 0);
+    M5.Lcd.printf("Pulse %d ms\nPause %d ms\nHands on %d?\nA: yes  B: no\n", dial.getPulseMs(), dial.getIntervalMs(), expectedPos);
+    Serial.printf("Hands on %d? Button A: yes, B: no\n", expectedPos);
+    if (waitForButton())
+    {
+        return true;
+    }
+    // calibration carries on from expectedPos
+    M5.Lcd.printf("Set hands to %d\nthen press A\n", expectedPos);
+    Serial.printf("Set the hands to %d by hand, then press button A\n", expectedPos);
+    while (!waitForButton())
+    {
+    }
+    return false;
+}
+
+bool calibrateClockDial(PwmBank &pwm, int clockA, int clockB)
+{
+    ClockDial dial;
+    dial.init(clockA, clockB, &pwm, 0);
+    // search down from the demo timing, a saved one may be too tight by now
+    dial.setTiming(CLOCK_PULSE_MS, CLOCK_INTERVAL_MS);
+    // calibrate() starts with the hands at rest on position 0
+    confirmWithButtons(dial, 0);
+
+    bool calibrated = dial.calibrate(&confirmWithButtons);
+    M5.Lcd.fillScreen(BLACK);
+    M5.Lcd.setCursor(0, 0);
+    if (calibrated)
+    {
+        dial.saveTiming();
+        M5.Lcd.printf("Saved pulse %d ms\npause %d ms\n", dial.getPulseMs(), dial.getIntervalMs());
+    }
+    else
+    {
+        M5.Lcd.println("Misses ticks,\nnot calibrated");
+    }
+    return calibrated;
+}
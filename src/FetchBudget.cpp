@@ -0,0 +1,290 @@
+// Fetch Budget
+//
+// Bounds every blocking step of a score poll. The overall budget is split across
+// the connect, TLS, header and body phases, and each read checks both the current
+// phase deadline and the overall deadline, so a server that stalls or trickles one
+// byte at a time cannot hold the scheduler for longer than the budget.
+
+#include "FetchBudget.h"
+
+const char *fetchErrorName(FetchError error)
+{
+    switch (error)
+    {
+    case FetchError::None:
+        return "none";
+    case FetchError::ConnectFailed:
+        return "connect failed";
+    case FetchError::ConnectTimeout:
+        return "connect timeout";
+    case FetchError::TlsTimeout:
+        return "TLS timeout";
+    case FetchError::HeaderTimeout:
+        return "header timeout";
+    case FetchError::BodyTimeout:
+        return "body timeout";
+    case FetchError::Closed:
+        return "connection closed";
+    case FetchError::Cancelled:
+        return "cancelled";
+    case FetchError::ByteLimit:
+        return "byte limit";
+    default:
+        return "unknown";
+    }
+}
+
+FetchBudget::FetchBudget(unsigned long totalMs)
+{
+    _start = millis();
+    _total = totalMs;
+    _error = FetchError::None;
+    _cancelled = false;
+    _bytesRead = 0;
+    _byteLimit = 0;
+    startPhase(FetchPhase::Connect);
+}
+
+unsigned long FetchBudget::phaseShare(FetchPhase phase)
+{
+    switch (phase)
+    {
+    case FetchPhase::Connect:
+        return _total * FETCH_SHARE_CONNECT / 100;
+    case FetchPhase::Tls:
+        return _total * FETCH_SHARE_TLS / 100;
+    case FetchPhase::Headers:
+        return _total * FETCH_SHARE_HEADERS / 100;
+    case FetchPhase::Body:
+        return _total * FETCH_SHARE_BODY / 100;
+    default:
+        return 0;
+    }
+}
+
+/// @brief Starts the next phase. Its deadline is its share of the budget, capped by the overall deadline.
+void FetchBudget::startPhase(FetchPhase phase)
+{
+    _phase = phase;
+    _phaseStart = elapsed();
+    _phaseDeadline = _phaseStart + phaseShare(phase);
+    if (_phaseDeadline > _total)
+    {
+        _phaseDeadline = _total;
+    }
+}
+
+FetchPhase FetchBudget::getPhase()
+{
+    return _phase;
+}
+
+unsigned long FetchBudget::elapsed()
+{
+    return millis() - _start;
+}
+
+unsigned long FetchBudget::phaseRemaining()
+{
+    unsigned long e = elapsed();
+    return e < _phaseDeadline ? _phaseDeadline - e : 0;
+}
+
+bool FetchBudget::expired()
+{
+    return _cancelled || elapsed() >= _phaseDeadline;
+}
+
+/// @brief Can be called from another task; the poll stops at its next deadline check.
+void FetchBudget::cancel()
+{
+    _cancelled = true;
+}
+
+bool FetchBudget::isCancelled()
+{
+    return _cancelled;
+}
+
+/// @brief Records the error of the poll. Only the first error is kept.
+void FetchBudget::fail(FetchError error)
+{
+    if (_error == FetchError::None)
+    {
+        _error = error;
+    }
+}
+
+FetchError FetchBudget::getError()
+{
+    return _error;
+}
+
+bool FetchBudget::ok()
+{
+    return _error == FetchError::None;
+}
+
+FetchError FetchBudget::timeoutError()
+{
+    if (_cancelled)
+    {
+        return FetchError::Cancelled;
+    }
+    switch (_phase)
+    {
+    case FetchPhase::Connect:
+        return FetchError::ConnectTimeout;
+    case FetchPhase::Tls:
+        return FetchError::TlsTimeout;
+    case FetchPhase::Headers:
+        return FetchError::HeaderTimeout;
+    default:
+        return FetchError::BodyTimeout;
+    }
+}
+
+/// @brief Connects within the connect and TLS shares of the budget.
+/// WiFiClientSecure does the TCP connect and the TLS handshake in one call, so which
+/// of the two ran out is inferred from the elapsed time: the TCP connect can never
+/// take longer than its own timeout.
+/// @return true when connected, otherwise the error is recorded on the budget
+bool FetchBudget::connect(WiFiClientSecure &client, const char *host, uint16_t port)
+{
+    startPhase(FetchPhase::Connect);
+    unsigned long connectMs = phaseRemaining();
+    if (connectMs == 0)
+    {
+        fail(timeoutError());
+        return false;
+    }
+    unsigned long tlsMs = phaseShare(FetchPhase::Tls);
+    client.setHandshakeTimeout((tlsMs + 999) / 1000); // in seconds
+
+    bool connected = client.connect(host, port, (int32_t)connectMs);
+    unsigned long took = elapsed() - _phaseStart;
+    if (_cancelled)
+    {
+        if (connected)
+        {
+            client.stop();
+        }
+        fail(FetchError::Cancelled);
+        return false;
+    }
+    if (!connected)
+    {
+        if (took > connectMs)
+        {
+            fail(FetchError::TlsTimeout);
+        }
+        else if (took >= connectMs * 9 / 10)
+        {
+            fail(FetchError::ConnectTimeout);
+        }
+        else
+        {
+            fail(FetchError::ConnectFailed);
+        }
+        return false;
+    }
+    if (elapsed() >= _total)
+    {
+        client.stop();
+        fail(FetchError::TlsTimeout);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Plain TCP connect within the connect share of the budget, for sources without TLS.
+/// @return true when connected, otherwise the error is recorded on the budget
+bool FetchBudget::connect(WiFiClient &client, const char *host, uint16_t port)
+{
+    startPhase(FetchPhase::Connect);
+    unsigned long connectMs = phaseRemaining();
+    if (connectMs == 0)
+    {
+        fail(timeoutError());
+        return false;
+    }
+    bool connected = client.connect(host, port, (int32_t)connectMs);
+    if (_cancelled)
+    {
+        if (connected)
+        {
+            client.stop();
+        }
+        fail(FetchError::Cancelled);
+        return false;
+    }
+    if (!connected)
+    {
+        fail(elapsed() - _phaseStart >= connectMs * 9 / 10 ? FetchError::ConnectTimeout : FetchError::ConnectFailed);
+        return false;
+    }
+    return true;
+}
+
+/// @brief Reads one line (without the '\n') into line within the deadline of the current
+/// phase. Lines longer than size - 1 are truncated, the rest of the line is dropped.
+/// @return FetchError::None for a complete line, FetchError::Closed when the peer closed
+/// the connection without sending more data, otherwise the timeout or byte limit that
+/// was recorded.
+FetchError FetchBudget::readLine(Client &client, char *line, size_t size)
+{
+    size_t len = 0;
+    line[0] = '\0';
+    while (true)
+    {
+        if (expired())
+        {
+            fail(timeoutError());
+            return _error;
+        }
+        if (_byteLimit && _bytesRead >= _byteLimit)
+        {
+            fail(FetchError::ByteLimit);
+            return _error;
+        }
+        if (client.available())
+        {
+            int c = client.read();
+            if (c < 0)
+            {
+                continue;
+            }
+            _bytesRead++;
+            if (c == '\n')
+            {
+                return FetchError::None;
+            }
+            if (len < size - 1)
+            {
+                line[len++] = (char)c;
+                line[len] = '\0';
+            }
+        }
+        else if (!client.connected())
+        {
+            return len > 0 ? FetchError::None : FetchError::Closed;
+        }
+        else
+        {
+            delay(1);
+        }
+    }
+}
+
+/// @brief Makes readLine fail with FetchError::ByteLimit once limit bytes have been read
+/// in this poll, 0 removes the limit
+void FetchBudget::setByteLimit(unsigned long limit)
+{
+    _byteLimit = limit;
+}
+
+/// @brief Bytes read by readLine in this poll, headers included
+unsigned long FetchBudget::bytesRead()
+{
+    return _bytesRead;
+}
@@ -0,0 +1,266 @@
+// Hedged Fetch
+//
+// When cricclubs.com is slow, a single stuck connect or read leaves the board stale
+// for a whole poll period. Hedging bounds the tail: once the primary source has
+// taken longer than the configured percentile of its recent latency, the same
+// scorecard is requested from the backup source and whichever answers first wins.
+
+#include "HedgedFetch.h"
+
+HedgedFetch::HedgedFetch(ScoreFetcher &primary, ScoreFetcher &backup)
+{
+    _fetchers[0] = &primary;
+    _fetchers[1] = &backup;
+    for (int i = 0; i < 2; i++)
+    {
+        _workers[i].running = false;
+        _workers[i].ok = false;
+    }
+}
+
+/// @brief Points the fetchers at their sources, an empty backup host disables hedging.
+/// A fetcher still finishing a cancelled request keeps its old source until a later
+/// call finds it idle, so its host is never rewritten while its worker reads it.
+void HedgedFetch::setSources(const char *primaryHost, uint16_t primaryPort, const char *backupHost, uint16_t backupPort)
+{
+    const char *hosts[2] = {primaryHost, backupHost};
+    uint16_t ports[2] = {primaryPort, backupPort};
+    for (int i = 0; i < 2; i++)
+    {
+        if (!isBusy(i) && !_fetchers[i]->isSource(hosts[i], ports[i]))
+        {
+            _fetchers[i]->setSource(hosts[i], ports[i]);
+        }
+    }
+}
+
+/// @brief True while the worker of source index still runs a request, cancelled or not
+bool HedgedFetch::isBusy(int index)
+{
+    return _workers[index].running;
+}
+
+void HedgedFetch::setPercentile(int percentile)
+{
+    _percentile = constrain(percentile, 1, 100);
+}
+
+void HedgedFetch::recordLatency(unsigned long latency)
+{
+    _latencies[_latencyNext] = latency;
+    _latencyNext = (_latencyNext + 1) % HEDGE_LATENCY_SAMPLES;
+    if (_latencyCount < HEDGE_LATENCY_SAMPLES)
+    {
+        _latencyCount++;
+    }
+}
+
+/// @brief How long the primary gets before the backup is asked as well
+/// @return the configured percentile of the recent primary latencies
+unsigned long HedgedFetch::hedgeDelay()
+{
+    if (_latencyCount < HEDGE_MIN_SAMPLES)
+    {
+        return HEDGE_DEFAULT_DELAY;
+    }
+    unsigned long sorted[HEDGE_LATENCY_SAMPLES];
+    memcpy(sorted, _latencies, sizeof(sorted));
+    // insertion sort, there are at most HEDGE_LATENCY_SAMPLES entries
+    for (size_t i = 1; i < _latencyCount; i++)
+    {
+        unsigned long v = sorted[i];
+        size_t j = i;
+        for (; j > 0 && sorted[j - 1] > v; j--)
+        {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = v;
+    }
+    size_t index = (_latencyCount * _percentile + 99) / 100 - 1;
+    return max(sorted[index], (unsigned long)HEDGE_MIN_DELAY);
+}
+
+void HedgedFetch::workerTask(void *arg)
+{
+    HedgeWorker *w = (HedgeWorker *)arg;
+    w->ok = w->fetcher->fetch(w->path, w->budget, w->details);
+    w->latency = w->budget.elapsed();
+    w->running = false;
+    xEventGroupSetBits(w->events, w->doneBit);
+    vTaskDelete(NULL);
+}
+
+/// @brief Starts the request of one source on its worker task
+/// @return false if the source is not configured or its worker is still busy with a cancelled request
+bool HedgedFetch::start(int index, const char *path)
+{
+    HedgeWorker &w = _workers[index];
+    if (w.running || !_fetchers[index]->isConfigured())
+    {
+        return false;
+    }
+    w.fetcher = _fetchers[index];
+    strncpy(w.path, path, SCORECARD_PATH_LEN - 1);
+    w.path[SCORECARD_PATH_LEN - 1] = '\0';
+    w.budget = FetchBudget(FETCH_BUDGET_MS);
+    w.details = MatchDetails();
+    w.ok = false;
+    w.latency = 0;
+    w.events = _events;
+    w.doneBit = 1 << index;
+    xEventGroupClearBits(_events, w.doneBit);
+    w.running = true;
+    if (xTaskCreate(&HedgedFetch::workerTask, index == 0 ? "fetchPrimary" : "fetchBackup", HEDGE_WORKER_STACK, &w, 1, NULL) != pdPASS)
+    {
+        w.running = false;
+        return false;
+    }
+    return true;
+}
+
+/// @brief Fetches the score, hedging with the backup source when the primary is slow
+/// @param details - set to the winning score
+/// @return true when one of the sources returned a valid score
+bool HedgedFetch::fetch(const char *path, MatchDetails &details)
+{
+    _polls++;
+    if (!_fetchers[1]->isConfigured())
+    {
+        if (isBusy(0))
+        {
+            // a cancelled request from when there was a backup has not stopped yet
+            _failures++;
+            return false;
+        }
+        // nothing to hedge with, fetch on the calling task
+        FetchBudget budget(FETCH_BUDGET_MS);
+        bool ok = _fetchers[0]->fetch(path, budget, details);
+        if (ok)
+        {
+            recordLatency(budget.elapsed());
+            _wins[0]++;
+        }
+        else
+        {
+            _failures++;
+        }
+        return ok;
+    }
+    if (_events == nullptr)
+    {
+        _events = xEventGroupCreate();
+    }
+
+    unsigned long started = millis();
+    unsigned long delayMs = hedgeDelay();
+    unsigned long limit = delayMs + FETCH_BUDGET_MS + 1000; // both requests are bounded by their own budget
+    int winner = -1;
+    EventBits_t pending = 0;
+    if (start(0, path))
+    {
+        pending |= _workers[0].doneBit;
+        EventBits_t bits = xEventGroupWaitBits(_events, pending, pdTRUE, pdFALSE, pdMS_TO_TICKS(delayMs));
+        if (bits & _workers[0].doneBit)
+        {
+            pending = 0;
+            if (_workers[0].ok)
+            {
+                winner = 0;
+            }
+        }
+    }
+    if (winner < 0 && start(1, path))
+    {
+        _hedges++;
+        pending |= _workers[1].doneBit;
+        Serial.printf("Primary has not answered in %lu ms, hedging with %s\n", millis() - started, _fetchers[1]->getHost());
+    }
+
+    while (winner < 0 && pending != 0)
+    {
+        unsigned long spent = millis() - started;
+        if (spent >= limit)
+        {
+            break;
+        }
+        EventBits_t bits = xEventGroupWaitBits(_events, pending, pdTRUE, pdFALSE, pdMS_TO_TICKS(limit - spent));
+        for (int i = 0; i < 2; i++)
+        {
+            if (bits & pending & _workers[i].doneBit)
+            {
+                pending &= ~_workers[i].doneBit;
+                if (_workers[i].ok && winner < 0)
+                {
+                    winner = i;
+                }
+            }
+        }
+    }
+
+    // the loser stops at its next deadline check and is reused once it has
+    for (int i = 0; i < 2; i++)
+    {
+        if (pending & _workers[i].doneBit)
+        {
+            _workers[i].budget.cancel();
+            if (i == 0)
+            {
+                // censored sample: the primary took at least this long
+                recordLatency(millis() - started);
+            }
+        }
+    }
+    if (winner == 0)
+    {
+        recordLatency(_workers[0].latency);
+    }
+
+    if (winner < 0)
+    {
+        _failures++;
+        return false;
+    }
+    _wins[winner]++;
+    details = _workers[winner].details;
+    Serial.printf("Score from %s in %lu ms\n", _fetchers[winner]->getHost(), millis() - started);
+    return true;
+}
+
+unsigned long HedgedFetch::getPolls()
+{
+    return _polls;
+}
+
+unsigned long HedgedFetch::getHedges()
+{
+    return _hedges;
+}
+
+unsigned long HedgedFetch::getWins(int index)
+{
+    return _wins[index];
+}
+
+unsigned long HedgedFetch::getFailures()
+{
+    return _failures;
+}
+
+/// @brief Prints the hedging counters and the stats of the idle fetchers. A fetcher
+/// whose cancelled request is still running is skipped, its worker writes that state.
+void HedgedFetch::print()
+{
+    Serial.printf("Hedging: polls: %lu\thedged: %lu (%lu%%)\tprimary wins: %lu\tbackup wins: %lu\tfailures: %lu\thedge delay: %lu ms\n",
+                  _polls, _hedges, _polls ? _hedges * 100 / _polls : 0, _wins[0], _wins[1], _failures, hedgeDelay());
+    for (int i = 0; i < 2; i++)
+    {
+        if (isBusy(i))
+        {
+            Serial.printf("Source %d still finishing a cancelled request\n", i);
+        }
+        else if (_fetchers[i]->isConfigured())
+        {
+            _fetchers[i]->print();
+        }
+    }
+}
@@ -0,0 +1,57 @@
+// I2C Trace
+//
+// Records every PCA9685 transaction made by the dials, so the bus time they take on
+// the I2C buses shared with the M5StickC peripherals, and the time interrupts are held
+// off around them, can be measured. The CSV export is replayed on the host by
+// tools/i2c_replay.cpp.
+
+#include "I2CTrace.h"
+
+#ifdef _I2C_TRACE_
+I2CTrace i2cTrace;
+#endif
+
+void I2CTrace::record(uint32_t startUs, uint32_t durationUs, uint8_t channel, uint8_t bytes, bool irqOff, uint8_t bus)
+{
+    portENTER_CRITICAL(&_lock);
+    I2CTraceRecord &r = _records[_next];
+    r.startUs = startUs;
+    r.durationUs = durationUs;
+    r.channel = channel;
+    r.bytes = bytes;
+    r.irqOff = irqOff;
+    r.bus = bus;
+    _next = (_next + 1) % I2C_TRACE_LEN;
+    _total++;
+    portEXIT_CRITICAL(&_lock);
+}
+
+size_t I2CTrace::count()
+{
+    return _total < I2C_TRACE_LEN ? _total : I2C_TRACE_LEN;
+}
+
+/// @brief Number of transactions recorded since the last clear, including overwritten ones
+unsigned long I2CTrace::getTotal()
+{
+    return _total;
+}
+
+void I2CTrace::clear()
+{
+    _next = 0;
+    _total = 0;
+}
+
+/// @brief Writes the kept records, oldest first, as CSV
+void I2CTrace::exportCsv(Print &out)
+{
+    out.println("start_us,duration_us,channel,bytes,irq_off,bus");
+    size_t n = count();
+    size_t first = (_next + I2C_TRACE_LEN - n) % I2C_TRACE_LEN;
+    for (size_t i = 0; i < n; i++)
+    {
+        const I2CTraceRecord &r = _records[(first + i) % I2C_TRACE_LEN];
+        out.printf("%lu,%lu,%u,%u,%d,%u\n", (unsigned long)r.startUs, (unsigned long)r.durationUs, r.channel, r.bytes, r.irqOff ? 1 : 0, r.bus);
+    }
+}
@@ -1,8 +1,5 @@
-#include <regex>
-#include <string>
 #include "MatchDetails.h"
-
-using namespace std;
+#include "ScoreParser.h"
 
 MatchDetails::MatchDetails()
 {
@@ -19,6 +16,7 @@ MatchDetails::MatchDetails()
         overDigits[i] = 0;
     }
     initialized = false;
+    fingerprint = 0;
 }
 
 void MatchDetails::setRuns(int runs)
@@ -94,6 +92,22 @@ bool MatchDetails::isInitialized()
     return initialized;
 }
 
+uint32_t MatchDetails::getFingerprint()
+{
+    return fingerprint;
+}
+
+static uint32_t lineFingerprint(const char *line)
+{
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (const char *p = line; *p; p++)
+    {
+        hash = (hash ^ (uint8_t)*p) * 16777619u;
+    }
+    return hash;
+}
+
 void MatchDetails::print()
 {
     _PP("runs: ");
@@ -104,51 +118,39 @@ void MatchDetails::print()
     _PL(overs);
 }
 
-MatchDetails *MatchDetails::getMatchDetails(WiFiClientSecure &client)
+/// @brief Reads the body line by line into the caller's line buffer until the score is found
+/// @param known - score of the page fetched last time, reused without parsing when the
+/// description line has the same fingerprint
+MatchDetails *MatchDetails::getMatchDetails(Client &client, FetchBudget &budget, char *line, size_t size, const MatchDetails *known)
 {
-    String sline("not empty");
+    strncpy(line, "not empty", size);
 
     Serial.println("Getting match details...");
 
-    while (!this->isInitialized() && sline.length() > 0)
+    while (!this->isInitialized() && line[0] != '\0')
     {
-        sline = client.readStringUntil('\n');
-        std::string line = sline.c_str();
-        Serial.println(sline);
-        if (line.find("description") != string::npos)
+        if (budget.readLine(client, line, size) != FetchError::None)
+        {
+            break;
+        }
+        Serial.println(line);
+        if (isScoreLine(line))
         {
-            // sample line
-            // <span id="line9"></span></span><span>&lt;<span class="start-tag">meta</span>
-            // <span class="attribute-name">name</span>='<a class="attribute-value">description</a>'
-            // <span class="attribute-name">content</span>='<a class="attribute-value">
-            // INDIA won by 73 Run(s);INDIA 184/7(20.0 overs) NEW ZEALAND 111/10(17.2 overs)</a>'
-            // <span>/</span>&gt;</span><span>
-
-            // first team playing
-            // SRI LANKA 267/3(88.0 overs)
-
-            // second team playing
-            // WEST INDIES 184/7(20.0 overs) SRI LANKA 267/3(88.0 overs)
-
-            // get the Runs/Wickets/(Overs
-            // using this regex /(\d+)\/(\d+)\((\d+)/gm
-
-            std::regex regex_pattern("(\\d+)\\/(\\d+)\\((\\d+)");
-            std::smatch match;
-            string::const_iterator searchStart(line.cbegin());
-            while (regex_search(searchStart, line.cend(), match, regex_pattern))
+            uint32_t lineHash = lineFingerprint(line);
+            if (known && known->initialized && known->fingerprint == lineHash)
+            {
+                *this = *known;
+                Serial.println("Description unchanged");
+                break;
+            }
+            ParsedScore score;
+            if (parseScoreLine(line, score))
             {
-                searchStart = match.suffix().first;
-                std::string sruns = match[1];
-                String runs(sruns.c_str());
-                std::string swickets = match[2];
-                String wickets(swickets.c_str());
-                std::string sovers = match[3];
-                String overs(sovers.c_str());
-                this->setRuns(runs.toInt());
-                this->setWickets(wickets.toInt());
-                this->setOvers(overs.toInt());
+                this->setRuns(score.runs);
+                this->setWickets(score.wickets);
+                this->setOvers(score.overs);
                 this->setInitialized(true);
+                this->fingerprint = lineHash;
             }
             this->print();
         }
@@ -0,0 +1,231 @@
+// Memory Telemetry
+//
+// Boards have been seen rebooting after a day or two. This keeps an hour of heap
+// samples, the stack high-water mark and the heap kept by every scheduler task, and
+// flags a leak when the free heap keeps falling.
+
+#include "MemoryTelemetry.h"
+
+MemorySample MemoryTelemetry::takeSample()
+{
+    MemorySample s;
+    s.millis = millis();
+    s.freeHeap = ESP.getFreeHeap();
+    s.minFreeHeap = ESP.getMinFreeHeap();
+    s.largestBlock = ESP.getMaxAllocHeap();
+    s.stackFree = uxTaskGetStackHighWaterMark(NULL);
+    return s;
+}
+
+/// @brief Adds a sample to the time series and checks the trend
+void MemoryTelemetry::sample()
+{
+    _samples[_next] = takeSample();
+    _next = (_next + 1) % TELEMETRY_SAMPLES;
+    if (_count < TELEMETRY_SAMPLES)
+    {
+        _count++;
+    }
+
+    bool leak = leakSuspected();
+    if (leak && !_leakReported)
+    {
+        Serial.printf("Memory leak suspected: free heap falling %.0f bytes/hour\n", -heapSlope());
+    }
+    _leakReported = leak;
+}
+
+TaskStackMark *MemoryTelemetry::findTask(const char *name)
+{
+    for (size_t i = 0; i < _taskCount; i++)
+    {
+        if (_tasks[i].name == name || strcmp(_tasks[i].name, name) == 0)
+        {
+            return &_tasks[i];
+        }
+    }
+    if (_taskCount == TELEMETRY_MAX_TASKS)
+    {
+        return nullptr;
+    }
+    TaskStackMark *mark = &_tasks[_taskCount++];
+    mark->name = name;
+    mark->stackFree = UINT32_MAX;
+    mark->minFreeHeap = UINT32_MAX;
+    mark->heapDelta = 0;
+    mark->worstHeapDelta = INT32_MAX;
+    mark->runs = 0;
+    mark->runsReported = 0;
+    mark->stackDrops = 0;
+    return mark;
+}
+
+/// @brief Runs a scheduler task callback and records the free heap before and after
+/// it and the stack high-water mark it leaves. Every Task callback goes through this.
+void MemoryTelemetry::runTask(const char *name, void (*callback)())
+{
+    uint32_t heapBefore = ESP.getFreeHeap();
+    callback();
+    uint32_t freeHeap = ESP.getFreeHeap();
+    uint32_t stackFree = uxTaskGetStackHighWaterMark(NULL);
+
+    TaskStackMark *mark = findTask(name);
+    if (mark == nullptr)
+    {
+        return;
+    }
+    int32_t delta = (int32_t)(freeHeap - heapBefore);
+    mark->runs++;
+    mark->heapDelta += delta;
+    if (delta < mark->worstHeapDelta)
+    {
+        mark->worstHeapDelta = delta;
+    }
+    if (stackFree < _stackFree)
+    {
+        if (_stackFree != UINT32_MAX)
+        {
+            mark->stackDrops++;
+        }
+        _stackFree = stackFree;
+    }
+    if (stackFree < mark->stackFree)
+    {
+        mark->stackFree = stackFree;
+    }
+    if (freeHeap < mark->minFreeHeap)
+    {
+        mark->minFreeHeap = freeHeap;
+    }
+}
+
+/// @brief Least squares slope of the free heap over the kept samples
+/// @return bytes per hour, negative when the free heap is shrinking
+float MemoryTelemetry::heapSlope()
+{
+    if (_count < 2)
+    {
+        return 0;
+    }
+    size_t first = (_next + TELEMETRY_SAMPLES - _count) % TELEMETRY_SAMPLES;
+    uint32_t t0 = _samples[first].millis;
+    double sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+    for (size_t i = 0; i < _count; i++)
+    {
+        const MemorySample &s = _samples[(first + i) % TELEMETRY_SAMPLES];
+        double x = (s.millis - t0) / 3600000.0; // hours
+        double y = s.freeHeap;
+        sumX += x;
+        sumY += y;
+        sumXX += x * x;
+        sumXY += x * y;
+    }
+    double denominator = _count * sumXX - sumX * sumX;
+    if (denominator <= 0)
+    {
+        return 0;
+    }
+    return (_count * sumXY - sumX * sumY) / denominator;
+}
+
+/// @brief A leak is suspected when the free heap trend is falling steeply over enough
+/// samples and the minimum free heap has also gone down within the window.
+bool MemoryTelemetry::leakSuspected()
+{
+    if (_count < TELEMETRY_LEAK_MIN_SAMPLES)
+    {
+        return false;
+    }
+    size_t first = (_next + TELEMETRY_SAMPLES - _count) % TELEMETRY_SAMPLES;
+    size_t last = (_next + TELEMETRY_SAMPLES - 1) % TELEMETRY_SAMPLES;
+    return heapSlope() < -TELEMETRY_LEAK_SLOPE && _samples[last].minFreeHeap < _samples[first].minFreeHeap;
+}
+
+void MemoryTelemetry::exportJson(String &out)
+{
+    MemorySample now = takeSample();
+    out = "{\"now\":{";
+    out += "\"millis\":";
+    out += now.millis;
+    out += ",\"freeHeap\":";
+    out += now.freeHeap;
+    out += ",\"minFreeHeap\":";
+    out += now.minFreeHeap;
+    out += ",\"largestBlock\":";
+    out += now.largestBlock;
+    out += ",\"stackFree\":";
+    out += now.stackFree;
+    out += "},\"heapSlopePerHour\":";
+    out += (long)heapSlope();
+    out += ",\"leakSuspected\":";
+    out += leakSuspected() ? "true" : "false";
+
+    out += ",\"tasks\":[";
+    for (size_t i = 0; i < _taskCount; i++)
+    {
+        const TaskStackMark &t = _tasks[i];
+        out += i > 0 ? ",{" : "{";
+        out += "\"name\":\"";
+        out += t.name;
+        out += "\",\"runs\":";
+        out += t.runs;
+        out += ",\"stackFree\":";
+        out += t.stackFree;
+        out += ",\"stackDrops\":";
+        out += t.stackDrops;
+        out += ",\"minFreeHeap\":";
+        out += t.minFreeHeap;
+        out += ",\"heapDelta\":";
+        out += t.heapDelta;
+        out += ",\"worstHeapDelta\":";
+        out += t.worstHeapDelta;
+        out += "}";
+    }
+
+    // columns: millis, freeHeap, minFreeHeap, largestBlock, stackFree
+    out += "],\"samples\":[";
+    size_t first = (_next + TELEMETRY_SAMPLES - _count) % TELEMETRY_SAMPLES;
+    for (size_t i = 0; i < _count; i++)
+    {
+        const MemorySample &s = _samples[(first + i) % TELEMETRY_SAMPLES];
+        out += i > 0 ? ",[" : "[";
+        out += s.millis;
+        out += ",";
+        out += s.freeHeap;
+        out += ",";
+        out += s.minFreeHeap;
+        out += ",";
+        out += s.largestBlock;
+        out += ",";
+        out += s.stackFree;
+        out += "]";
+    }
+    out += "]}";
+}
+
+void MemoryTelemetry::print()
+{
+    MemorySample now = takeSample();
+    Serial.printf("Memory: free: %lu\tmin free: %lu\tlargest block: %lu\tstack free: %lu\tslope: %.0f B/h\n",
+                  (unsigned long)now.freeHeap, (unsigned long)now.minFreeHeap, (unsigned long)now.largestBlock,
+                  (unsigned long)now.stackFree, heapSlope());
+    for (size_t i = 0; i < _taskCount; i++)
+    {
+        const TaskStackMark &t = _tasks[i];
+        Serial.printf("  %-12s runs: %lu\theap delta: %ld (worst run %ld)\tstack free: %lu\n", t.name, t.runs,
+                      (long)t.heapDelta, (long)t.worstHeapDelta, (unsigned long)t.stackFree);
+    }
+}
+
+/// @brief Prints how many times each task callback ran since the previous call
+void MemoryTelemetry::printTaskRuns()
+{
+    Serial.print("Callbacks since last report:");
+    for (size_t i = 0; i < _taskCount; i++)
+    {
+        TaskStackMark &t = _tasks[i];
+        Serial.printf(" %s %lu", t.name, t.runs - t.runsReported);
+        t.runsReported = t.runs;
+    }
+    Serial.println();
+}
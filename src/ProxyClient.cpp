@@ -0,0 +1,157 @@
+// Proxy Client
+//
+// Client mode of getScoreCB: instead of a TLS request and a full scorecard page,
+// the board sends a ~25 byte request to tools/scoreproxy.cpp running on a LAN host
+// and gets back the score fields that changed since its sequence number, and how
+// old the proxy's score is.
+
+#include "ProxyClient.h"
+
+void ProxyClient::setProxy(const char *host, uint16_t port)
+{
+    if (strcmp(host, _host) != 0 || port != _port)
+    {
+        strncpy(_host, host, sizeof(_host) - 1);
+        _host[sizeof(_host) - 1] = '\0';
+        _port = port;
+        _haveScore = false;
+        _missedInRow = 0;
+    }
+}
+
+bool ProxyClient::isConfigured()
+{
+    return _host[0] != '\0';
+}
+
+void ProxyClient::reset(uint32_t matchId, uint32_t clubId)
+{
+    _matchId = matchId;
+    _clubId = clubId;
+    _haveScore = false;
+    _score = {};
+}
+
+/// @brief After PROXY_BACKOFF_AFTER unanswered polls in a row, skips the proxy for
+/// PROXY_BACKOFF_BASE, doubling with every further unanswered poll up to PROXY_BACKOFF_MAX
+void ProxyClient::backOff()
+{
+    _missedInRow++;
+    if (_missedInRow < PROXY_BACKOFF_AFTER)
+    {
+        return;
+    }
+    unsigned long backoff = PROXY_BACKOFF_BASE;
+    for (unsigned long i = PROXY_BACKOFF_AFTER; i < _missedInRow && backoff < PROXY_BACKOFF_MAX; i++)
+    {
+        backoff *= 2;
+    }
+    backoff = min(backoff, (unsigned long)PROXY_BACKOFF_MAX);
+    _retryAt = millis() + backoff;
+    Serial.printf("Proxy %s missed %lu polls in a row, fetching directly for %lu s\n", _host, _missedInRow, backoff / 1000);
+}
+
+/// @brief Asks the proxy for the score of the match
+/// @return true when details holds the proxy's current score, false when the proxy did
+/// not answer, is being skipped after not answering, has no score for the match yet or
+/// only a stale one
+bool ProxyClient::fetch(const char *tournament, uint32_t matchId, uint32_t clubId, MatchDetails &details)
+{
+    if (_missedInRow >= PROXY_BACKOFF_AFTER && (long)(millis() - _retryAt) < 0)
+    {
+        _skipped++;
+        return false;
+    }
+    if (!_started)
+    {
+        _started = _udp.begin(PROXY_PORT);
+    }
+    if (matchId != _matchId || clubId != _clubId)
+    {
+        reset(matchId, clubId);
+    }
+    _polls++;
+
+    ProxyRequest request = {};
+    request.epoch = _haveScore ? _score.epoch : 0;
+    request.seq = _haveScore ? _score.seq : 0;
+    request.matchId = matchId;
+    request.clubId = clubId;
+    strncpy(request.tournament, tournament, PROXY_TOURNAMENT_LEN);
+    uint8_t out[PROXY_REQUEST_MAX_LEN];
+    size_t outLen = encodeProxyRequest(request, out, sizeof(out));
+
+    uint8_t in[PROXY_REPLY_MAX_LEN + 1];
+    for (int attempt = 0; attempt < PROXY_ATTEMPTS; attempt++)
+    {
+        _udp.beginPacket(_host, _port);
+        _udp.write(out, outLen);
+        _udp.endPacket();
+        _bytesOut += outLen;
+
+        unsigned long sent = millis();
+        while (millis() - sent < PROXY_TIMEOUT)
+        {
+            if (_udp.parsePacket() <= 0)
+            {
+                delay(5);
+                continue;
+            }
+            int len = _udp.read(in, sizeof(in));
+            if (len <= 0)
+            {
+                continue;
+            }
+            _bytesIn += len;
+            // fields the proxy left out are unchanged, so decode on top of what we have
+            ProxyReply reply = _score;
+            if (!decodeProxyReply(in, len, reply))
+            {
+                continue;
+            }
+            bool sameEpoch = _haveScore && reply.epoch == _score.epoch;
+            if (sameEpoch && reply.seq < _score.seq)
+            {
+                continue; // late answer to an earlier request
+            }
+            _missedInRow = 0;
+            if (reply.seq == 0)
+            {
+                Serial.println("Proxy has no score for the match yet");
+                return false;
+            }
+            if (!sameEpoch && reply.mask != PROXY_ALL)
+            {
+                continue; // a delta against a score we do not have
+            }
+            if (sameEpoch && reply.seq == _score.seq)
+            {
+                _unchanged++;
+            }
+            _score = reply;
+            _haveScore = true;
+            if (reply.age > PROXY_MAX_AGE)
+            {
+                // keep the seq for the next delta, but do not show a score the proxy could not refresh
+                _stale++;
+                Serial.printf("Proxy score is %u s old, fetching directly\n", reply.age);
+                return false;
+            }
+            details.setRuns(_score.runs);
+            details.setOvers(_score.overs);
+            details.setWickets(_score.wickets);
+            details.setInitialized(true);
+            return true;
+        }
+    }
+    _failures++;
+    Serial.printf("No answer from proxy %s\n", _host);
+    backOff();
+    return false;
+}
+
+void ProxyClient::print()
+{
+    Serial.printf("Proxy: polls: %lu\tunchanged: %lu\tfailures: %lu\tskipped: %lu\tstale: %lu\tseq: %lu\tage: %u s\tbytes out: %lu\tbytes in: %lu\n",
+                  _polls, _unchanged, _failures, _skipped, _stale, (unsigned long)_score.seq, _score.age, _bytesOut, _bytesIn);
+}
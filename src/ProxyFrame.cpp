@@ -0,0 +1,138 @@
+// Proxy Frame
+//
+// Encoding of the scoreproxy request and delta reply, see ProxyFrame.h for the layout.
+
+#include <string.h>
+#include "ProxyFrame.h"
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, v >> 16);
+    put16(p + 2, v & 0xffff);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+static bool checkHeader(const uint8_t *buf, size_t len, size_t minLen, uint8_t type)
+{
+    return len >= minLen && buf[0] == PROXY_MAGIC0 && buf[1] == PROXY_MAGIC1 && buf[2] == PROXY_VERSION && buf[3] == type;
+}
+
+static void putHeader(uint8_t *buf, uint8_t type)
+{
+    buf[0] = PROXY_MAGIC0;
+    buf[1] = PROXY_MAGIC1;
+    buf[2] = PROXY_VERSION;
+    buf[3] = type;
+}
+
+size_t encodeProxyRequest(const ProxyRequest &request, uint8_t *buf, size_t len)
+{
+    size_t tournamentLen = strnlen(request.tournament, PROXY_TOURNAMENT_LEN);
+    if (len < 19 + tournamentLen)
+    {
+        return 0;
+    }
+    putHeader(buf, PROXY_REQUEST);
+    put16(buf + 4, request.epoch);
+    put32(buf + 6, request.seq);
+    put32(buf + 10, request.matchId);
+    put32(buf + 14, request.clubId);
+    buf[18] = tournamentLen;
+    memcpy(buf + 19, request.tournament, tournamentLen);
+    return 19 + tournamentLen;
+}
+
+bool decodeProxyRequest(const uint8_t *buf, size_t len, ProxyRequest &request)
+{
+    if (!checkHeader(buf, len, 19, PROXY_REQUEST) || buf[18] > PROXY_TOURNAMENT_LEN || len != 19u + buf[18])
+    {
+        return false;
+    }
+    request.epoch = get16(buf + 4);
+    request.seq = get32(buf + 6);
+    request.matchId = get32(buf + 10);
+    request.clubId = get32(buf + 14);
+    memcpy(request.tournament, buf + 19, buf[18]);
+    request.tournament[buf[18]] = '\0';
+    return true;
+}
+
+size_t encodeProxyReply(const ProxyReply &reply, uint8_t *buf, size_t len)
+{
+    if (len < PROXY_REPLY_MAX_LEN)
+    {
+        return 0;
+    }
+    putHeader(buf, PROXY_REPLY);
+    put16(buf + 4, reply.epoch);
+    put32(buf + 6, reply.seq);
+    buf[10] = reply.mask & PROXY_ALL;
+    put16(buf + 11, reply.age);
+    size_t n = PROXY_REPLY_HEADER_LEN;
+    if (reply.mask & PROXY_RUNS)
+    {
+        put16(buf + n, reply.runs);
+        n += 2;
+    }
+    if (reply.mask & PROXY_OVERS)
+    {
+        put16(buf + n, reply.overs);
+        n += 2;
+    }
+    if (reply.mask & PROXY_WICKETS)
+    {
+        buf[n++] = reply.wickets;
+    }
+    return n;
+}
+
+/// @brief Decodes a reply. Fields not in the mask are left untouched, so decoding
+/// into the score the board already has applies the delta.
+bool decodeProxyReply(const uint8_t *buf, size_t len, ProxyReply &reply)
+{
+    if (!checkHeader(buf, len, PROXY_REPLY_HEADER_LEN, PROXY_REPLY))
+    {
+        return false;
+    }
+    uint8_t mask = buf[10];
+    size_t expected = PROXY_REPLY_HEADER_LEN + ((mask & PROXY_RUNS) ? 2 : 0) + ((mask & PROXY_OVERS) ? 2 : 0) + ((mask & PROXY_WICKETS) ? 1 : 0);
+    if (len != expected || (mask & ~PROXY_ALL))
+    {
+        return false;
+    }
+    reply.epoch = get16(buf + 4);
+    reply.seq = get32(buf + 6);
+    reply.mask = mask;
+    reply.age = get16(buf + 11);
+    size_t n = PROXY_REPLY_HEADER_LEN;
+    if (mask & PROXY_RUNS)
+    {
+        reply.runs = get16(buf + n);
+        n += 2;
+    }
+    if (mask & PROXY_OVERS)
+    {
+        reply.overs = get16(buf + n);
+        n += 2;
+    }
+    if (mask & PROXY_WICKETS)
+    {
+        reply.wickets = buf[n];
+    }
+    return true;
+}
@@ -0,0 +1,208 @@
+// PWM Bank
+//
+// One global Adafruit_PWMServoDriver on Wire caps the scoreboard at 16 dials and
+// writes them one setPWM at a time. The bank drives every PCA9685 found on Wire and
+// Wire1. A score update queues the new dial positions and flush() puts them on both
+// buses at the same time, so the update takes about as long as the busiest bus
+// however many dials there are.
+//
+// The Adafruit driver is only used to reset the boards and set the frequency, which
+// also turns on register auto increment. The channel writes are issued directly, so
+// consecutive channels share one transaction: 2 + 4 bytes per channel, at most 66
+// bytes for a whole board, within the ESP32 Wire buffer.
+
+#include "PwmBank.h"
+#include "I2CTrace.h"
+
+#define BUS_START_BIT(bus) (1 << (bus))
+#define BUS_DONE_BIT(bus) (1 << ((bus) + 8))
+
+void PwmBank::addBus(TwoWire &wire)
+{
+    if (_busCount < PWM_BANK_MAX_BUSES)
+    {
+        _buses[_busCount].bank = this;
+        _buses[_busCount].index = _busCount;
+        _buses[_busCount].wire = &wire;
+        _busCount++;
+    }
+}
+
+bool PwmBank::probe(TwoWire &wire, uint8_t addr)
+{
+    wire.beginTransmission(addr);
+    return wire.endTransmission() == 0;
+}
+
+/// @brief Finds the boards, resets them and sets their PWM frequency
+/// @return number of channels available
+int PwmBank::begin(float freq)
+{
+    for (int b = 0; b < _busCount; b++)
+    {
+        _buses[b].wire->begin(); // keeps the pins if the bus is already started
+    }
+    for (int a = 0; a < PCA9685_ADDRS; a++)
+    {
+        for (int b = 0; b < _busCount && _boardCount < PWM_BANK_MAX_BOARDS; b++)
+        {
+            if (probe(*_buses[b].wire, PCA9685_FIRST_ADDR + a))
+            {
+                _boards[_boardCount].bus = b;
+                _boards[_boardCount].addr = PCA9685_FIRST_ADDR + a;
+                _boardCount++;
+            }
+        }
+    }
+    if (_boardCount == 0 && _busCount > 0)
+    {
+        Serial.println("No PCA9685 answered, assuming one at 0x40 on the first bus");
+        _boards[0].bus = 0;
+        _boards[0].addr = PCA9685_FIRST_ADDR;
+        _boardCount = 1;
+    }
+
+    for (int i = 0; i < _boardCount; i++)
+    {
+        PwmBoard &board = _boards[i];
+        board.driver = new Adafruit_PWMServoDriver(board.addr, *_buses[board.bus].wire);
+        board.driver->begin();
+        board.driver->setPWMFreq(freq);
+        board.dirty = 0;
+    }
+
+    _events = xEventGroupCreate();
+    for (int b = 1; b < _busCount; b++)
+    {
+        xTaskCreate(&PwmBank::busTask, "pwmBus", PWM_BUS_TASK_STACK, &_buses[b], 2, NULL);
+    }
+    print();
+    return getChannelCount();
+}
+
+int PwmBank::getChannelCount()
+{
+    return _boardCount * PCA9685_CHANNELS;
+}
+
+/// @brief Queues a write of channel, it goes out with the next flush().
+/// A channel beyond the boards found is ignored.
+void PwmBank::setPWM(int channel, uint16_t on, uint16_t off)
+{
+    if (channel < 0 || channel >= getChannelCount())
+    {
+        Serial.printf("No PCA9685 channel %d\n", channel);
+        return;
+    }
+    PwmBoard &board = _boards[channel / PCA9685_CHANNELS];
+    int c = channel % PCA9685_CHANNELS;
+    board.on[c] = on;
+    board.off[c] = off;
+    board.dirty |= 1 << c;
+}
+
+/// @brief Writes the queued channels of the boards on one bus
+void PwmBank::writeBus(int bus)
+{
+    TwoWire &wire = *_buses[bus].wire;
+    for (int i = 0; i < _boardCount; i++)
+    {
+        PwmBoard &board = _boards[i];
+        if (board.bus != bus)
+        {
+            continue;
+        }
+        int c = 0;
+        while (board.dirty)
+        {
+            if (!(board.dirty & (1 << c)))
+            {
+                c++;
+                continue;
+            }
+            // one transaction for this run of changed channels
+            int first = c;
+            I2C_TRACE_BEGIN();
+            wire.beginTransmission(board.addr);
+            wire.write(PCA9685_LED0_ON_L + 4 * first);
+            while (c < PCA9685_CHANNELS && (board.dirty & (1 << c)))
+            {
+                wire.write(board.on[c] & 0xff);
+                wire.write(board.on[c] >> 8);
+                wire.write(board.off[c] & 0xff);
+                wire.write(board.off[c] >> 8);
+                board.dirty &= ~(1 << c);
+                c++;
+            }
+            wire.endTransmission();
+            I2C_TRACE_END_BUS(bus, i * PCA9685_CHANNELS + first, PCA9685_SETPWM_BYTES + 4 * (c - first - 1), false);
+            _transactions++;
+        }
+    }
+}
+
+void PwmBank::busTask(void *arg)
+{
+    PwmBus *bus = (PwmBus *)arg;
+    while (true)
+    {
+        xEventGroupWaitBits(bus->bank->_events, BUS_START_BIT(bus->index), pdTRUE, pdTRUE, portMAX_DELAY);
+        bus->bank->writeBus(bus->index);
+        xEventGroupSetBits(bus->bank->_events, BUS_DONE_BIT(bus->index));
+    }
+}
+
+/// @brief Writes every queued channel and returns once all buses are done
+void PwmBank::flush()
+{
+    unsigned long started = micros();
+    EventBits_t start = 0;
+    EventBits_t done = 0;
+    bool local = false;
+    for (int i = 0; i < _boardCount; i++)
+    {
+        if (_boards[i].dirty == 0)
+        {
+            continue;
+        }
+        if (_boards[i].bus == 0)
+        {
+            local = true;
+        }
+        else
+        {
+            start |= BUS_START_BIT(_boards[i].bus);
+            done |= BUS_DONE_BIT(_boards[i].bus);
+        }
+    }
+    if (!local && !start)
+    {
+        return;
+    }
+    if (start)
+    {
+        xEventGroupSetBits(_events, start);
+    }
+    if (local)
+    {
+        writeBus(0);
+    }
+    if (done)
+    {
+        xEventGroupWaitBits(_events, done, pdTRUE, pdTRUE, portMAX_DELAY);
+    }
+    _flushes++;
+    _lastFlushUs = micros() - started;
+    _maxFlushUs = max(_maxFlushUs, _lastFlushUs);
+}
+
+void PwmBank::print()
+{
+    Serial.printf("PWM bank: %d boards, %d channels\tflushes: %lu\ttransactions: %lu\tlast flush: %lu us\tlongest: %lu us\n",
+                  _boardCount, getChannelCount(), _flushes, _transactions, _lastFlushUs, _maxFlushUs);
+    for (int i = 0; i < _boardCount; i++)
+    {
+        Serial.printf("  channels %d-%d: PCA9685 0x%02x on Wire%s\n", i * PCA9685_CHANNELS, (i + 1) * PCA9685_CHANNELS - 1,
+                      _boards[i].addr, _boards[i].bus ? "1" : "");
+    }
+}
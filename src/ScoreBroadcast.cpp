@@ -0,0 +1,180 @@
+// Score Broadcast
+//
+// For events where several boards show the same match, only the leader polls
+// cricclubs. It multicasts a ScoreFrame after every poll, with a new sequence
+// number whenever the score changed, so the unchanged frames double as heartbeats.
+// Followers feed the received score straight into the dial pipeline.
+
+#include <esp_system.h>
+#include "ScoreBroadcast.h"
+
+BoardRole boardRoleFromName(const char *name)
+{
+    if (strcmp(name, "leader") == 0)
+    {
+        return ROLE_LEADER;
+    }
+    if (strcmp(name, "follower") == 0)
+    {
+        return ROLE_FOLLOWER;
+    }
+    return ROLE_STANDALONE;
+}
+
+/// @brief Joins the score group. Needs WiFi to be connected. Called again after a WiFi
+/// reconnect or when the match changes, which starts over from a clean state.
+/// @param role - what this board does with the score
+/// @param matchId - frames for other matches are ignored
+/// @return true when the board takes part in score sharing
+bool ScoreBroadcast::begin(BoardRole role, uint32_t matchId)
+{
+    if (_started)
+    {
+        _transport.leave();
+        _started = false;
+    }
+    _role = role;
+    _matchId = matchId;
+    _haveLast = false;
+    _leader = {};
+    _askNow = true;
+    if (_role == ROLE_STANDALONE)
+    {
+        return false;
+    }
+    _started = _transport.join();
+    if (_role == ROLE_LEADER)
+    {
+        _last.epoch = esp_random() & 0xffff;
+        _last.seq = 0;
+    }
+    Serial.printf("Score sharing for match %lu started as %s: %d\n", (unsigned long)_matchId, _role == ROLE_LEADER ? "leader" : "follower", _started);
+    return _started;
+}
+
+BoardRole ScoreBroadcast::getRole()
+{
+    return _role;
+}
+
+uint32_t ScoreBroadcast::getMatchId()
+{
+    return _matchId;
+}
+
+void ScoreBroadcast::send(const ScorePeer &to, ScoreFrame &frame)
+{
+    uint8_t buf[SCORE_FRAME_LEN];
+    size_t len = encodeScoreFrame(frame, buf, sizeof(buf));
+    _transport.send(to, buf, len);
+}
+
+/// @brief Leader only: multicasts the score, with a new sequence number if it changed.
+void ScoreBroadcast::publish(MatchDetails &details)
+{
+    if (!_started || _role != ROLE_LEADER || !details.isInitialized())
+    {
+        return;
+    }
+    if (!_haveLast || _last.runs != details.getRuns() || _last.overs != details.getOvers() || _last.wickets != details.getWickets())
+    {
+        _last.seq++;
+    }
+    _last.type = FRAME_SCORE;
+    _last.matchId = _matchId;
+    _last.runs = details.getRuns();
+    _last.overs = details.getOvers();
+    _last.wickets = details.getWickets();
+    _haveLast = true;
+    send(ScorePeer{}, _last);
+}
+
+void ScoreBroadcast::sendRequest()
+{
+    ScoreFrame request = {};
+    request.type = FRAME_REQUEST;
+    request.matchId = _matchId;
+    // ask the leader directly once it is known, otherwise whoever leads the group
+    send(_leader, request);
+    _lastRequest = millis();
+    _askNow = false;
+    _requestsSent++;
+}
+
+/// @brief Handles the received frames. The leader answers requests, a follower applies new scores.
+/// @param details - set to the received score when a follower got a new one
+/// @return true when details was updated
+bool ScoreBroadcast::poll(MatchDetails &details)
+{
+    if (!_started)
+    {
+        return false;
+    }
+    bool updated = false;
+    uint8_t buf[SCORE_FRAME_LEN + 1];
+    ScoreFrame frame;
+    ScorePeer from;
+    int len;
+    while ((len = _transport.receive(buf, sizeof(buf), from)) > 0)
+    {
+        if (!decodeScoreFrame(buf, len, frame) || frame.matchId != _matchId)
+        {
+            continue;
+        }
+        if (_role == ROLE_LEADER && frame.type == FRAME_REQUEST && _haveLast)
+        {
+            send(from, _last);
+            _requestsAnswered++;
+        }
+        else if (_role == ROLE_FOLLOWER && frame.type == FRAME_SCORE)
+        {
+            _leader = from;
+            _lastHeard = millis();
+            _framesReceived++;
+            bool sameLeader = _haveLast && frame.epoch == _last.epoch;
+            if (sameLeader && frame.seq <= _last.seq)
+            {
+                continue; // heartbeat or duplicate
+            }
+            if (sameLeader && frame.seq > _last.seq + 1)
+            {
+                // every frame carries the whole score, so skipping ahead repairs the gap
+                _framesMissed += frame.seq - _last.seq - 1;
+            }
+            _last = frame;
+            _haveLast = true;
+            details.setRuns(frame.runs);
+            details.setOvers(frame.overs);
+            details.setWickets(frame.wickets);
+            details.setInitialized(true);
+            updated = true;
+        }
+    }
+
+    if (_role == ROLE_FOLLOWER && (!_haveLast || millis() - _lastHeard > SCORE_STALE_PERIOD) && (_askNow || millis() - _lastRequest > SCORE_REQUEST_RETRY))
+    {
+        sendRequest();
+    }
+    return updated;
+}
+
+unsigned long ScoreBroadcast::getFramesReceived()
+{
+    return _framesReceived;
+}
+
+unsigned long ScoreBroadcast::getFramesMissed()
+{
+    return _framesMissed;
+}
+
+unsigned long ScoreBroadcast::getRequestsAnswered()
+{
+    return _requestsAnswered;
+}
+
+void ScoreBroadcast::print()
+{
+    Serial.printf("Score sharing: role: %d\tepoch: %u\tseq: %lu\treceived: %lu\tmissed: %lu\trequests sent: %lu\tanswered: %lu\n",
+                  _role, _last.epoch, (unsigned long)_last.seq, _framesReceived, _framesMissed, _requestsSent, _requestsAnswered);
+}
@@ -0,0 +1,315 @@
+// Score Fetcher
+//
+// One request to one scorecard source: connect, send the request, skip the
+// headers and read the body until MatchDetails finds the score, all within the
+// given FetchBudget. Safe to run on a worker task; it touches no globals.
+//
+// Polls are conditional: the ETag and Last-Modified of the last page are sent back
+// as If-None-Match / If-Modified-Since, and a 304 reuses the cached score without
+// reading a body. Sources that send neither still cost a download, but an unchanged
+// description line is recognised by its fingerprint in MatchDetails.
+//
+// The score is in one line near the top of the page. Once its offset is known, polls
+// send a Range request around it, or, if the source answers with the whole page,
+// stop reading SCORE_TAG_MARGIN bytes past it. Either way the socket is closed as
+// soon as the score is parsed.
+
+#include "ScoreFetcher.h"
+
+/// @brief Not to be called while a fetch of this source runs on another task.
+/// A new source starts without the validators and offsets learned from the old one.
+void ScoreFetcher::setSource(const char *host, uint16_t port)
+{
+    if (isSource(host, port))
+    {
+        return;
+    }
+    strncpy(_host, host, SOURCE_HOST_LEN - 1);
+    _host[SOURCE_HOST_LEN - 1] = '\0';
+    _port = port == 0 ? 443 : port;
+    _cachedPath[0] = '\0';
+    forgetPage();
+}
+
+/// @brief Drops the validators, score, offsets and Range verdict learned from the last page
+void ScoreFetcher::forgetPage()
+{
+    _etag[0] = '\0';
+    _lastModified[0] = '\0';
+    _cached = MatchDetails();
+    _tagStart = 0;
+    _tagEnd = 0;
+    _pageSize = 0;
+    _range = RangeSupport::Unknown;
+}
+
+bool ScoreFetcher::isSource(const char *host, uint16_t port)
+{
+    return strncmp(_host, host, SOURCE_HOST_LEN - 1) == 0 && _port == (port == 0 ? 443 : port);
+}
+
+const char *ScoreFetcher::getHost()
+{
+    return _host;
+}
+
+bool ScoreFetcher::isConfigured()
+{
+    return _host[0] != '\0';
+}
+
+/// @brief Fetches the scorecard at path from this source
+/// @return true when the score was found, otherwise the reason is recorded on the budget
+bool ScoreFetcher::fetch(const char *path, FetchBudget &budget, MatchDetails &details)
+{
+    bool connected;
+    bool again = false;
+    do
+    {
+        // a second round only follows a 416, for the full page within what is left of the budget
+        if (_port == 443)
+        {
+            WiFiClientSecure client;
+            client.setInsecure();
+            connected = budget.connect(client, _host, _port);
+            again = connected && request(client, path, budget, details);
+        }
+        else
+        {
+            WiFiClient client;
+            connected = budget.connect(client, _host, _port);
+            again = connected && request(client, path, budget, details);
+        }
+    } while (again);
+
+    if (!connected)
+    {
+        Serial.printf("Connection to %s failed: %s after %lu ms\n", _host, fetchErrorName(budget.getError()), budget.elapsed());
+    }
+    else if (!budget.ok())
+    {
+        Serial.printf("Score poll of %s stopped: %s after %lu ms\n", _host, fetchErrorName(budget.getError()), budget.elapsed());
+    }
+    return details.isInitialized();
+}
+
+/// @brief Copies the value of header name from line into value
+/// @return false if line is a different header or the value does not fit
+static bool headerValue(const char *line, const char *name, char *value, size_t size)
+{
+    size_t nameLen = strlen(name);
+    if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':')
+    {
+        return false;
+    }
+    const char *start = line + nameLen + 1;
+    while (*start == ' ')
+    {
+        start++;
+    }
+    size_t len = strcspn(start, "\r");
+    if (len == 0 || len >= size)
+    {
+        return false;
+    }
+    memcpy(value, start, len);
+    value[len] = '\0';
+    return true;
+}
+
+/// @brief Sends the request on a connected client and reads the reply into details
+/// @return true when the learned range was not satisfiable (416): the offsets are
+/// forgotten and the full page has to be requested again
+bool ScoreFetcher::request(Client &client, const char *path, FetchBudget &budget, MatchDetails &details)
+{
+    Serial.printf("Connected to %s!\n", _host);
+    if (strcmp(path, _cachedPath) != 0)
+    {
+        // another match, what we know about the old page is of no use
+        strncpy(_cachedPath, path, SCORECARD_PATH_LEN - 1);
+        _cachedPath[SCORECARD_PATH_LEN - 1] = '\0';
+        forgetPage();
+    }
+    _requests++;
+    // Make a HTTP request:
+    client.print("GET ");
+    client.print(_port == 443 ? "https://" : "http://");
+    client.print(_host);
+    if (_port != 443 && _port != 80)
+    {
+        client.print(":");
+        client.print(_port);
+    }
+    client.print(path);
+    client.println(" HTTP/1.0");
+    client.print("Host: ");
+    client.println(_host);
+    if (_cached.isInitialized())
+    {
+        if (_etag[0])
+        {
+            client.print("If-None-Match: ");
+            client.println(_etag);
+        }
+        if (_lastModified[0])
+        {
+            client.print("If-Modified-Since: ");
+            client.println(_lastModified);
+        }
+    }
+    bool ranged = _tagEnd > 0 && _range != RangeSupport::No;
+    if (ranged)
+    {
+        client.print("Range: bytes=");
+        client.print(_tagStart > SCORE_TAG_MARGIN ? _tagStart - SCORE_TAG_MARGIN : 0);
+        client.print("-");
+        client.println(_tagEnd + SCORE_TAG_MARGIN);
+    }
+    client.println("Connection: close");
+    client.println();
+
+    budget.startPhase(FetchPhase::Headers);
+    unsigned long requestStart = budget.bytesRead(); // not 0 after a 416 in the same poll
+    int status = 0;
+    char etag[VALIDATOR_LEN] = "";
+    char lastModified[VALIDATOR_LEN] = "";
+    char value[VALIDATOR_LEN];
+    unsigned long contentLength = 0;
+    unsigned long bodyOffset = 0; // offset in the page of the first body byte
+    unsigned long totalLength = 0;
+    while (budget.readLine(client, _line, sizeof(_line)) == FetchError::None)
+    {
+        if (status == 0)
+        {
+            // status line, e.g. HTTP/1.1 304 Not Modified
+            const char *code = strchr(_line, ' ');
+            status = code ? atoi(code + 1) : -1;
+        }
+        else if (strcmp(_line, "\r") == 0)
+        {
+            Serial.println("headers received");
+            break;
+        }
+        else if (headerValue(_line, "Content-Length", value, sizeof(value)))
+        {
+            contentLength = strtoul(value, nullptr, 10);
+        }
+        else if (headerValue(_line, "Content-Range", value, sizeof(value)))
+        {
+            // bytes <first>-<last>/<total>
+            const char *first = strchr(value, ' ');
+            const char *total = strchr(value, '/');
+            bodyOffset = first ? strtoul(first + 1, nullptr, 10) : 0;
+            totalLength = total ? strtoul(total + 1, nullptr, 10) : 0;
+        }
+        else if (!headerValue(_line, "ETag", etag, sizeof(etag)))
+        {
+            headerValue(_line, "Last-Modified", lastModified, sizeof(lastModified));
+        }
+    }
+
+    unsigned long headerBytes = budget.bytesRead() - requestStart;
+    bool retryFullPage = false;
+    if (status == 416 && ranged)
+    {
+        // the page shrank below the learned offset: its body is an error page, not the scorecard
+        Serial.printf("%s cannot serve the learned range, fetching the full page\n", _host);
+        _tagStart = 0;
+        _tagEnd = 0;
+        _pageSize = totalLength;
+        retryFullPage = budget.ok();
+    }
+    else if (status == 206)
+    {
+        _range = RangeSupport::Yes;
+        _pageSize = totalLength ? totalLength : _pageSize;
+    }
+    else if (status == 200)
+    {
+        if (ranged)
+        {
+            Serial.printf("%s ignores Range, reading up to the learned offset\n", _host);
+            _range = RangeSupport::No;
+        }
+        bodyOffset = 0;
+        _pageSize = contentLength ? contentLength : _pageSize;
+        if (_tagEnd > 0)
+        {
+            budget.setByteLimit(budget.bytesRead() + _tagEnd + SCORE_TAG_MARGIN);
+        }
+    }
+
+    if (budget.ok() && status == 304 && _cached.isInitialized())
+    {
+        Serial.printf("Scorecard on %s not modified\n", _host);
+        _notModified++;
+        details = _cached;
+    }
+    // if the headers arrived within the budget,
+    // read the body of the page until the score is found:
+    else if (budget.ok() && (status == 200 || status == 206))
+    {
+        budget.startPhase(FetchPhase::Body);
+        unsigned long bodyStart = budget.bytesRead();
+        details.getMatchDetails(client, budget, _line, sizeof(_line), &_cached);
+        unsigned long bodyBytes = budget.bytesRead() - bodyStart;
+        if (details.isInitialized())
+        {
+            // reading stopped right after the description line, which is still in _line
+            _tagEnd = bodyOffset + bodyBytes;
+            _tagStart = _tagEnd - min((unsigned long)strlen(_line) + 1, _tagEnd);
+            if (_pageSize > _tagEnd)
+            {
+                _earlyCloses++;
+            }
+            if (_cached.isInitialized() && details.getFingerprint() == _cached.getFingerprint())
+            {
+                _sameFingerprint++;
+            }
+            _cached = details;
+            strcpy(_etag, etag);
+            strcpy(_lastModified, lastModified);
+        }
+        else
+        {
+            if (budget.ok() && status == 200)
+            {
+                // the whole page went by without a score
+                _pageSize = bodyBytes;
+            }
+            // the page changed shape, learn the offset again from a full read
+            _tagStart = 0;
+            _tagEnd = 0;
+        }
+    }
+    unsigned long requestBytes = budget.bytesRead() - requestStart;
+    _bytesDownloaded += requestBytes;
+    if (!retryFullPage)
+    {
+        _bytesFullPage += max(headerBytes + _pageSize, requestBytes);
+    }
+    client.stop();
+    Serial.printf("Connection to %s closed.\n", _host);
+    return retryFullPage;
+}
+
+/// @brief Polls answered with 304, the cached score reused without a body
+unsigned long ScoreFetcher::getNotModified()
+{
+    return _notModified;
+}
+
+/// @brief Polls whose description line matched the cached one, reused without parsing
+unsigned long ScoreFetcher::getSameFingerprint()
+{
+    return _sameFingerprint;
+}
+
+void ScoreFetcher::print()
+{
+    Serial.printf("%s: requests: %lu\tnot modified: %lu\tsame fingerprint: %lu\tvalidators: %s%s\n", _host, _requests, _notModified,
+                  _sameFingerprint, _etag[0] ? "ETag " : "", _lastModified[0] ? "Last-Modified" : "");
+    Serial.printf("%s: downloaded: %lu of %lu full page bytes (%lu%%)\tearly closes: %lu\tscore at: %lu-%lu of %lu\trange: %s\n", _host,
+                  _bytesDownloaded, _bytesFullPage, _bytesFullPage ? _bytesDownloaded * 100 / _bytesFullPage : 0, _earlyCloses,
+                  _tagStart, _tagEnd, _pageSize, _range == RangeSupport::Yes ? "yes" : _range == RangeSupport::No ? "no" : "unknown");
+}
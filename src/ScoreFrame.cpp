@@ -0,0 +1,66 @@
+// Score Frame
+//
+// Packs the score into a fixed size frame so that boards can share it without
+// each of them fetching and parsing the scorecard page.
+
+#include "ScoreFrame.h"
+
+static void put16(uint8_t *p, uint16_t v)
+{
+    p[0] = v >> 8;
+    p[1] = v & 0xff;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    put16(p, v >> 16);
+    put16(p + 2, v & 0xffff);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return ((uint16_t)p[0] << 8) | p[1];
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return ((uint32_t)get16(p) << 16) | get16(p + 2);
+}
+
+/// @brief Encodes the frame into buf.
+/// @return number of bytes written, 0 if buf is too small
+size_t encodeScoreFrame(const ScoreFrame &frame, uint8_t *buf, size_t len)
+{
+    if (len < SCORE_FRAME_LEN)
+    {
+        return 0;
+    }
+    buf[0] = SCORE_FRAME_MAGIC0;
+    buf[1] = SCORE_FRAME_MAGIC1;
+    buf[2] = SCORE_FRAME_VERSION;
+    buf[3] = frame.type;
+    put16(buf + 4, frame.epoch);
+    put32(buf + 6, frame.seq);
+    put32(buf + 10, frame.matchId);
+    put16(buf + 14, frame.runs);
+    put16(buf + 16, frame.overs);
+    buf[18] = frame.wickets;
+    return SCORE_FRAME_LEN;
+}
+
+/// @brief Decodes a frame, rejecting anything with the wrong size, magic or version.
+bool decodeScoreFrame(const uint8_t *buf, size_t len, ScoreFrame &frame)
+{
+    if (len != SCORE_FRAME_LEN || buf[0] != SCORE_FRAME_MAGIC0 || buf[1] != SCORE_FRAME_MAGIC1 || buf[2] != SCORE_FRAME_VERSION)
+    {
+        return false;
+    }
+    frame.type = buf[3];
+    frame.epoch = get16(buf + 4);
+    frame.seq = get32(buf + 6);
+    frame.matchId = get32(buf + 10);
+    frame.runs = get16(buf + 14);
+    frame.overs = get16(buf + 16);
+    frame.wickets = buf[18];
+    return true;
+}
@@ -0,0 +1,74 @@
+// Score Parser
+//
+// The score is in the meta description of the scorecard page, e.g.
+//   <meta name='description' content='INDIA won by 73 Run(s);INDIA 184/7(20.0 overs) NEW ZEALAND 111/10(17.2 overs)'/>
+// first team playing:
+//   SRI LANKA 267/3(88.0 overs)
+// second team playing:
+//   WEST INDIES 184/7(20.0 overs) SRI LANKA 267/3(88.0 overs)
+// The last Runs/Wickets(Overs group on the line is the team currently batting.
+
+#include <ctype.h>
+#include <string.h>
+#include "ScoreParser.h"
+
+/// @brief True for the lines that can carry the score
+bool isScoreLine(const char *line)
+{
+    return strstr(line, "description") != nullptr;
+}
+
+/// @brief Reads the digits at p into value
+/// @return the character after the digits, nullptr if p is not at a digit
+static const char *readNumber(const char *p, int &value)
+{
+    if (!isdigit((unsigned char)*p))
+    {
+        return nullptr;
+    }
+    value = 0;
+    while (isdigit((unsigned char)*p))
+    {
+        value = value * 10 + (*p++ - '0');
+    }
+    return p;
+}
+
+/// @brief Parses the last Runs/Wickets(Overs group of a description line
+/// @return false if the line is not a description line or has no score
+bool parseScoreLine(const char *line, ParsedScore &score)
+{
+    if (!isScoreLine(line))
+    {
+        return false;
+    }
+    // get the Runs/Wickets/(Overs, what the regex /(\d+)\/(\d+)\((\d+)/gm matched,
+    // scanned by hand to keep <regex> out of the firmware
+    bool found = false;
+    const char *p = line;
+    while (*p)
+    {
+        if (!isdigit((unsigned char)*p))
+        {
+            p++;
+            continue;
+        }
+        int runs, wickets, overs;
+        const char *q = readNumber(p, runs);
+        if (*q == '/' && (q = readNumber(q + 1, wickets)) && *q == '(' && (q = readNumber(q + 1, overs)))
+        {
+            score.runs = runs;
+            score.wickets = wickets;
+            score.overs = overs;
+            found = true;
+            p = q;
+            continue;
+        }
+        // no group can start inside this run of digits either
+        while (isdigit((unsigned char)*p))
+        {
+            p++;
+        }
+    }
+    return found;
+}
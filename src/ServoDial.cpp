@@ -12,10 +12,10 @@
 #include "ServoDial.h"
 
 /// @brief Initializes the dial with the wire connection and also the position it is supposed to be.
-/// @param servoConnection - wire on PCA9685 PWM chip
-/// @param pwm - Adafruit PWM Servo Driver
+/// @param servoConnection - channel of the PWM bank
+/// @param pwm - PCA9685 boards the dials are wired to
 /// @param prevPos - What the position was when the program started
-void ServoDial::init(int servoConnection, Adafruit_PWMServoDriver *pwm, int prevPos)
+void ServoDial::init(int servoConnection, PwmBank *pwm, int prevPos)
 {
     _pwm = pwm;
     _currPos = prevPos;
@@ -38,13 +38,13 @@ int ServoDial::des_pos_to_val(int desPos)
     return pwm_value;
 }
 
+/// @brief Queues the move, it happens with the next PwmBank::flush() together with
+/// the other dials
 void ServoDial::setPos(int desPos)
 {
     int pwm_value = this->des_pos_to_val(desPos);
     _currPos = desPos;
-    cli(); // Interrupt disabled for indivisible processing
     _pwm->setPWM(_servoConnection, 0, pwm_value);
-    sei();   // Interrupt enabled because the setting is completed
     Serial.println("Setting Complete");
     this->print();
 }
@@ -0,0 +1,43 @@
+// UDP Score Transport
+//
+// The score group is a multicast group on the board's WiFi network. The membership
+// does not survive a WiFi reconnect, so the owner calls join() again after one;
+// WiFiUDP drops the old socket and membership first.
+
+#include "UdpScoreTransport.h"
+
+bool UdpScoreTransport::join()
+{
+    return _udp.beginMulticast(SCORE_GROUP_IP, SCORE_GROUP_PORT);
+}
+
+void UdpScoreTransport::leave()
+{
+    _udp.stop();
+}
+
+bool UdpScoreTransport::send(const ScorePeer &to, const uint8_t *buf, size_t len)
+{
+    if (to.port == 0)
+    {
+        _udp.beginMulticastPacket();
+    }
+    else
+    {
+        _udp.beginPacket(IPAddress(to.ip), to.port);
+    }
+    _udp.write(buf, len);
+    return _udp.endPacket();
+}
+
+int UdpScoreTransport::receive(uint8_t *buf, size_t size, ScorePeer &from)
+{
+    if (_udp.parsePacket() <= 0)
+    {
+        return 0;
+    }
+    int len = _udp.read(buf, size);
+    from.ip = (uint32_t)_udp.remoteIP();
+    from.port = _udp.remotePort();
+    return len;
+}
@@ -20,7 +20,7 @@
 ////// Board Setup /////////////////////////////////////////////////////////////////////////
 #include <M5StickC.h>
 #undef min
-#include <Adafruit_PWMServoDriver.h>
+#include "PwmBank.h"
 #include "ServoDial.h"
 
 #include <WiFiClientSecure.h>
@@ -32,9 +32,6 @@
 #define _TASK_STATUS_REQUEST    // Compile with support for StatusRequest functionality - triggering tasks on status change events in addition to time only
 #include <TaskScheduler.h>
 
-#include <regex>
-#include <string>
-
 // Scheduler
 Scheduler ts;
 #define DURATION 10000
@@ -44,19 +41,59 @@ Scheduler ts;
 //#define _TEST_
 
 #include "MatchDetails.h"
+#include "FetchBudget.h"
+#include "ScoreFetcher.h"
+#include "HedgedFetch.h"
+#include "ProxyClient.h"
+#include "ScoreBroadcast.h"
+#include "UdpScoreTransport.h"
+#include "BootState.h"
+#include "I2CTrace.h"
+#include "MemoryTelemetry.h"
+#include "ClockDialCalibration.h"
+#ifdef _I2C_TRACE_
+#include <StreamString.h>
+#endif
 
 #define PERIOD1 500
 #define DURATION 10000
-#define SCORE_PERIOD 60000        // 1 minute
-#define CONFIG_SAVE_PERIOD 600000 // 10 minutes
+#define SCORE_PERIOD 60000       // 1 minute
+#define CONFIG_QUIET_PERIOD 5000 // save the dial positions once they have not moved for 5 seconds
+#define SCORE_LISTEN_PERIOD 100  // how often leaders and followers check for score frames
 
 void blink1CB();
 void getScoreCB();
+void parseScoreCB();
+void setDialsCB();
 void saveConfigCB();
-
-Task tBlink1(PERIOD1 *TASK_MILLISECOND, DURATION / PERIOD1, &blink1CB, &ts, true);
-Task tGetScore(SCORE_PERIOD *TASK_MILLISECOND, TASK_FOREVER, &getScoreCB, &ts, true);
-Task tSaveConfig(CONFIG_SAVE_PERIOD *TASK_MILLISECOND, TASK_FOREVER, &saveConfigCB, &ts, true);
+void listenScoreCB();
+void telemetryCB();
+
+// The score is handled as a pipeline of tasks:
+//   tGetScore (periodic) --srFetched--> tParseScore --restart--> tSetDials --restartDelayed--> tSaveConfig
+// On a follower board tListenScore takes the place of tGetScore and signals srFetched
+// whenever the leader multicasts a new score, the status telling the parse stage
+// whether a score was found. Only the first stage runs on a timer. The other stages
+// are idle until the previous stage starts them, and tSaveConfig runs once the dials
+// have been quiet for CONFIG_QUIET_PERIOD, since every move restarts its delay.
+StatusRequest srFetched;
+
+// Heap and stack telemetry, served at /telemetry
+MemoryTelemetry memoryTelemetry;
+
+// Every task callback runs through the telemetry, which records its heap and stack use
+#define TRACKED(callback) []() { memoryTelemetry.runTask(#callback, &callback); }
+
+Task tBlink1(PERIOD1 *TASK_MILLISECOND, DURATION / PERIOD1, TRACKED(blink1CB), &ts, true);
+Task tGetScore(SCORE_PERIOD *TASK_MILLISECOND, TASK_FOREVER, TRACKED(getScoreCB), &ts, true);
+Task tParseScore(TASK_IMMEDIATE, TASK_ONCE, TRACKED(parseScoreCB), &ts, false);
+Task tSetDials(TASK_IMMEDIATE, TASK_ONCE, TRACKED(setDialsCB), &ts, false);
+Task tSaveConfig(TASK_IMMEDIATE, TASK_ONCE, TRACKED(saveConfigCB), &ts, false);
+Task tListenScore(SCORE_LISTEN_PERIOD *TASK_MILLISECOND, TASK_FOREVER, TRACKED(listenScoreCB), &ts, false);
+Task tTelemetry(TELEMETRY_PERIOD *TASK_MILLISECOND, TASK_FOREVER, TRACKED(telemetryCB), &ts, true);
+
+// Pipeline metrics, reported on every poll with the callbacks each task ran since the last one
+unsigned long fetchedMillis = 0; // when the last fetch completed
 
 unsigned long prevMillis = millis();
 const char *cricclubs_server = "cricclubs.com";
@@ -67,7 +104,7 @@ const char *cricclubs_server = "cricclubs.com";
 #define LED_BUILTIN 10
 
 // -- Configuration specific key. The value should be modified if config structure was changed.
-#define CONFIG_VERSION "sb2"
+#define CONFIG_VERSION "sb3"
 
 // -- When CONFIG_PIN is pulled to ground on startup, the Thing will use the initial
 //      password to buld an AP. (E.g. in case of lost password)
@@ -87,7 +124,8 @@ bool formValidator(iotwebconf::WebRequestWrapper *webRequestWrapper);
 DNSServer dnsServer;
 WebServer server(80);
 
-Adafruit_PWMServoDriver pwm = Adafruit_PWMServoDriver();
+// Every PCA9685 found on Wire (and Wire1 with _PWM_WIRE1_), dial i is channel i
+PwmBank pwm;
 
 // using namespace std;
 
@@ -112,16 +150,25 @@ bool dial_initialization_complete = false;
 
 
 char internalClockPosValue[NUM_DIALS][NUMBER_LEN];
-String labels[NUM_DIALS];
-String ids[NUM_DIALS];
+char labels[NUM_DIALS][STRING_LEN];
+char ids[NUM_DIALS][NUMBER_LEN];
 IotWebConfNumberParameter *internalClockPos[NUM_DIALS];
 char tournamentIdValue[NUMBER_LEN];
+char boardRoleValue[STRING_LEN];
+char backupHostValue[STRING_LEN];
+char backupPortValue[NUMBER_LEN];
+char hedgePercentileValue[NUMBER_LEN];
+char proxyHostValue[STRING_LEN];
 char clubIdValue[NUMBER_LEN];
 char matchIdValue[NUMBER_LEN];
 int prev_runs = 0;
 int prev_overs = 0;
 int prev_wickets = 0;
 bool config_updated = false;
+MatchDetails fetchedDetails; // handed from the fetch stage to the parse stage
+bool restoredFromRtc = false;
+unsigned long bootToScoreMs = 0; // dials showing a known score, restored or fetched
+unsigned long bootToFetchMs = 0; // first score fetched (or received from the leader)
 
 IotWebConf iotWebConf(thingName, &dnsServer, &server, wifiInitialApPassword, CONFIG_VERSION);
 // -- You can also use namespace formats e.g.: iotwebconf::TextParameter
@@ -131,6 +178,27 @@ IotWebConfParameterGroup sbSettings = iotwebconf::ParameterGroup("sbSettings", "
 IotWebConfNumberParameter clubId = IotWebConfNumberParameter("Club ID", "clubId", clubIdValue, NUMBER_LEN, "0", "1..1000000", "min='0' max='1000000' step='1'");
 IotWebConfNumberParameter matchId = IotWebConfNumberParameter("Match ID", "matchId", matchIdValue, NUMBER_LEN, "0", "1..1000000", "min='0' max='1000000' step='1'");
 IotWebConfTextParameter tournamentId = iotwebconf::TextParameter("Tournament ID", "tournamentId", tournamentIdValue, NUMBER_LEN, "NACL");
+static char boardRoleValues[][STRING_LEN] = {"standalone", "leader", "follower"};
+static char boardRoleNames[][STRING_LEN] = {"Standalone", "Leader (fetches and shares the score)", "Follower (shows the leader's score)"};
+IotWebConfSelectParameter boardRole = IotWebConfSelectParameter("Board role (needs restart)", "boardRole", boardRoleValue, STRING_LEN, (char *)boardRoleValues, (char *)boardRoleNames, sizeof(boardRoleValues) / STRING_LEN, STRING_LEN, "standalone");
+
+IotWebConfTextParameter backupHost = IotWebConfTextParameter("Backup source host (mirror or relay, empty for none)", "backupHost", backupHostValue, STRING_LEN, "");
+IotWebConfNumberParameter backupPort = IotWebConfNumberParameter("Backup source port (443 for TLS)", "backupPort", backupPortValue, NUMBER_LEN, "443", "1..65535", "min='1' max='65535' step='1'");
+IotWebConfNumberParameter hedgePercentile = IotWebConfNumberParameter("Hedge after this percentile of primary latency", "hedgePercentile", hedgePercentileValue, NUMBER_LEN, "90", "1..100", "min='1' max='100' step='1'");
+IotWebConfTextParameter proxyHost = IotWebConfTextParameter("Score proxy host (empty to fetch directly)", "proxyHost", proxyHostValue, STRING_LEN, "");
+
+// Score sources. The backup is only asked when the primary is slower than usual.
+ScoreFetcher primarySource;
+ScoreFetcher backupSource;
+HedgedFetch hedgedFetch(primarySource, backupSource);
+// When a scoreproxy runs on the LAN it is asked first, the sources above are the fallback
+ProxyClient proxyClient;
+
+// Shares the score between boards showing the same match
+UdpScoreTransport scoreTransport;
+ScoreBroadcast scoreBroadcast(scoreTransport);
+bool wifiWasConnected = false;
+bool wifiReconnected = false; // the score group membership was lost with the connection
 
 void setDials(MatchDetails &matchDetails, ServoDial dials[NUM_DIALS])
 {
@@ -146,7 +214,19 @@ void setDials(MatchDetails &matchDetails, ServoDial dials[NUM_DIALS])
     {
       dials[i].setPos(values[i]);
     }
+    pwm.flush();
+  }
+}
+
+// Mirrors the dial positions and score into RTC memory so a warm reset can restore them
+void saveDialSnapshot()
+{
+  int positions[NUM_DIALS];
+  for (int i = 0; i < NUM_DIALS; i++)
+  {
+    positions[i] = dials[i].getPos();
   }
+  saveBootSnapshot(positions, NUM_DIALS, prev_runs, prev_overs, prev_wickets);
 }
 
 void getScoreCB()
@@ -157,8 +237,12 @@ void getScoreCB()
   _PP((currentMillis - prevMillis) / 1000);
   _PL(" seconds");
   prevMillis = millis();
-  WiFiClientSecure client;
-  client.setInsecure();
+  memoryTelemetry.printTaskRuns();
+
+  // the parse stage runs as soon as this fetch signals completion
+  srFetched.setWaiting();
+  tParseScore.waitFor(&srFetched);
+  fetchedDetails = MatchDetails();
 
   Serial.println("\nStarting connection to cricclubs server...");
   Serial.print("Match ID:");
@@ -166,103 +250,126 @@ void getScoreCB()
   Serial.print("Club ID:");
   Serial.println(clubIdValue);
 
-  M5.Lcd.println("Starting connection to cricclubs server...");
-  if (!client.connect(cricclubs_server, 443))
+  proxyClient.setProxy(proxyHostValue);
+  bool fromProxy = proxyClient.isConfigured() && proxyClient.fetch(tournamentIdValue, atoi(matchIdValue), atoi(clubIdValue), fetchedDetails);
+  if (proxyClient.isConfigured())
   {
-    Serial.println("Connection to cricclubs failed!");
+    proxyClient.print();
   }
-  else
+  if (!fromProxy)
   {
-    Serial.println("Connected to cricclubs server!");
-    // Make a HTTP request:
-    String req("GET https://cricclubs.com/");
-    req += tournamentIdValue;
-    req += "/viewScorecard.do?matchId=";
-    req += atoi(matchIdValue);
-    req += "&clubId=";
-    req += atoi(clubIdValue);
-    req += " HTTP/1.0";
-    client.println(req);
-    client.println("Host: cricclubs.com");
-    client.println("Connection: close");
-    client.println();
-
-    while (client.connected())
-    {
-      String line = client.readStringUntil('\n');
-      if (line == "\r")
-      {
-        Serial.println("headers received");
-        break;
-      }
-    }
-    // if there are incoming bytes available
-    // from the server, read them and print them:
-    while (client.available())
+    // no proxy, or it is down, being skipped or only has a stale score
+    M5.Lcd.println("Starting connection to cricclubs server...");
+    hedgedFetch.setSources(cricclubs_server, 443, backupHostValue, atoi(backupPortValue));
+    hedgedFetch.setPercentile(atoi(hedgePercentileValue));
+    char path[SCORECARD_PATH_LEN];
+    snprintf(path, sizeof(path), "/%s/viewScorecard.do?matchId=%d&clubId=%d", tournamentIdValue, atoi(matchIdValue), atoi(clubIdValue));
+    hedgedFetch.fetch(path, fetchedDetails);
+    hedgedFetch.print();
+  }
+  fetchedMillis = millis();
+  scoreBroadcast.publish(fetchedDetails);
+  srFetched.signalComplete(fetchedDetails.isInitialized() ? 0 : -1);
+}
+
+void listenScoreCB()
+{
+  // (re)join after every WiFi (re)connect and start over when the match is changed in the portal
+  uint32_t match = atoi(matchIdValue);
+  if (wifiReconnected || match != scoreBroadcast.getMatchId())
+  {
+    wifiReconnected = false;
+    scoreBroadcast.begin(boardRoleFromName(boardRoleValue), match);
+  }
+
+  MatchDetails received;
+  if (scoreBroadcast.poll(received))
+  {
+    // a follower skips the fetch and hands the leader's score to the parse stage
+    scoreBroadcast.print();
+    srFetched.setWaiting();
+    tParseScore.waitFor(&srFetched);
+    fetchedDetails = received;
+    fetchedMillis = millis();
+    srFetched.signalComplete(0);
+  }
+}
+
+void parseScoreCB()
+{
+  if (srFetched.getStatus() < 0)
+  {
+    Serial.println("No Title found for ");
+    Serial.println(clubIdValue);
+    Serial.println(matchIdValue);
+    M5.Lcd.fillScreen(BLACK);
+    M5.Lcd.setCursor(0, 0);
+    M5.Lcd.println("No Title found for ");
+    M5.Lcd.println(clubIdValue);
+    M5.Lcd.println(matchIdValue);
+    return;
+  }
+
+  if (bootToFetchMs == 0)
+  {
+    bootToFetchMs = millis();
+    if (bootToScoreMs == 0)
     {
-      MatchDetails matchDetails;
-      matchDetails.getMatchDetails(client);
-      if (matchDetails.isInitialized())
-      {
-        String message("Title found for ");
-        String clubIDMessage("Club ID:");
-        clubIDMessage += atoi(clubIdValue);
-        message += clubIDMessage;
-        message += " ";
-        String matchIDMessage("Match ID:");
-        matchIDMessage += atoi(matchIdValue);
-        message += matchIDMessage;
-        Serial.println(message);
-        M5.Lcd.fillScreen(BLACK);
-        M5.Lcd.setCursor(0, 0);
-        M5.Lcd.println(tournamentIdValue);
-        M5.Lcd.println(clubIDMessage);
-        M5.Lcd.println(matchIDMessage);
-        String runsMessage = "Runs: ";
-        runsMessage += matchDetails.getRuns();
-        M5.Lcd.println(runsMessage);
-        String wicketsMessage = "Wickets: ";
-        wicketsMessage += matchDetails.getWickets();
-        M5.Lcd.println(wicketsMessage);
-        String oversMessage = "Overs: ";
-        oversMessage += matchDetails.getOvers();
-        M5.Lcd.println(oversMessage);
-        if (prev_runs != matchDetails.getRuns() || prev_overs != matchDetails.getOvers() || prev_wickets != matchDetails.getWickets())
-        {
-          prev_runs = matchDetails.getRuns();
-          prev_overs = matchDetails.getOvers();
-          prev_wickets = matchDetails.getWickets();
-          setDials(matchDetails, dials);
-          config_updated = true;
-        }
-        else
-        {
-          config_updated = false;
-          Serial.println("No update required as previous values are same");
-        }
-      }
-      else
-      {
-        Serial.println("No Title found for ");
-        Serial.println(clubIdValue);
-        Serial.println(matchIdValue);
-        M5.Lcd.fillScreen(BLACK);
-        M5.Lcd.setCursor(0, 0);
-        M5.Lcd.println("No Title found for ");
-        M5.Lcd.println(clubIdValue);
-        M5.Lcd.println(matchIdValue);
-      }
-      break;
+      bootToScoreMs = bootToFetchMs;
     }
-    client.stop();
-    Serial.println("Connection to cricclubs server closed.");
+    saveBootToScore(bootToScoreMs);
+    Serial.printf("Boot to first score: %lu ms, boot to first fetch: %lu ms\n", bootToScoreMs, bootToFetchMs);
+  }
+
+  String message("Title found for ");
+  String clubIDMessage("Club ID:");
+  clubIDMessage += atoi(clubIdValue);
+  message += clubIDMessage;
+  message += " ";
+  String matchIDMessage("Match ID:");
+  matchIDMessage += atoi(matchIdValue);
+  message += matchIDMessage;
+  Serial.println(message);
+  M5.Lcd.fillScreen(BLACK);
+  M5.Lcd.setCursor(0, 0);
+  M5.Lcd.println(tournamentIdValue);
+  M5.Lcd.println(clubIDMessage);
+  M5.Lcd.println(matchIDMessage);
+  String runsMessage = "Runs: ";
+  runsMessage += fetchedDetails.getRuns();
+  M5.Lcd.println(runsMessage);
+  String wicketsMessage = "Wickets: ";
+  wicketsMessage += fetchedDetails.getWickets();
+  M5.Lcd.println(wicketsMessage);
+  String oversMessage = "Overs: ";
+  oversMessage += fetchedDetails.getOvers();
+  M5.Lcd.println(oversMessage);
+  if (prev_runs != fetchedDetails.getRuns() || prev_overs != fetchedDetails.getOvers() || prev_wickets != fetchedDetails.getWickets())
+  {
+    prev_runs = fetchedDetails.getRuns();
+    prev_overs = fetchedDetails.getOvers();
+    prev_wickets = fetchedDetails.getWickets();
+    tSetDials.restart();
+  }
+  else
+  {
+    Serial.println("No update required as previous values are same");
   }
 }
 
-void saveConfigCB()
+void setDialsCB()
 {
-  Serial.println("\nChecking whether config was updated...");
+  setDials(fetchedDetails, dials);
+  saveDialSnapshot();
+  config_updated = true;
+  Serial.printf("Dials set %lu ms after the fetch completed\n", millis() - fetchedMillis);
 
+  // every move restarts the quiet period, so the config is written once the dials settle
+  tSaveConfig.restartDelayed(CONFIG_QUIET_PERIOD * TASK_MILLISECOND);
+}
+
+void saveConfigCB()
+{
   if (config_updated && dial_initialization_complete)
   {
     Serial.println("\nSaving config...");
@@ -277,11 +384,12 @@ void saveConfigCB()
     Serial.println("Config saved.");
     M5.Lcd.println("Config saved.");
   }
-  else
-  {
-    Serial.println("No config changes to save.");
-    M5.Lcd.println("No config changes to save.");
-  }
+}
+
+void telemetryCB()
+{
+  memoryTelemetry.sample();
+  memoryTelemetry.print();
 }
 
 inline void LEDOn()
@@ -330,8 +438,16 @@ void setup()
   M5.Lcd.println("hello world.");
 
   Serial.begin(115200);
-  pwm.begin();
-  pwm.setPWMFreq(60); // Setting it to 60 Hz ~50Hz~  as recommended by the https://dronebotworkshop.com/esp32-servo/ page
+  pwm.addBus(Wire);
+#ifdef _PWM_WIRE1_
+  // shared with the internal devices M5.begin() started it for, see PwmBank.h
+  pwm.addBus(Wire1);
+#endif
+  // Setting it to 60 Hz ~50Hz~  as recommended by the https://dronebotworkshop.com/esp32-servo/ page
+  if (pwm.begin(60) < NUM_DIALS)
+  {
+    Serial.printf("Only %d PWM channels for %d dials\n", pwm.getChannelCount(), NUM_DIALS);
+  }
 
   // if you want to really speed stuff up, you can go into 'fast 400khz I2C' mode
   // some i2c devices dont like this so much so if you're sharing the bus, watch
@@ -340,31 +456,54 @@ void setup()
   Serial.println();
   Serial.println("Starting up...");
 
+  // After a brownout or watchdog reset, put the last known score back on the dials
+  // right away. The config portal, WiFi and the first fetch all come later.
+  BootSnapshot snapshot;
+  restoredFromRtc = restoreBootSnapshot(snapshot) && snapshot.dialCount == NUM_DIALS;
+  if (restoredFromRtc)
+  {
+    for (int i = 0; i < NUM_DIALS; i++)
+    {
+      dials[i].init(i, &pwm, snapshot.dialPos[i]);
+      dials[i].setPos(snapshot.dialPos[i]);
+    }
+    pwm.flush();
+    prev_runs = snapshot.runs;
+    prev_overs = snapshot.overs;
+    prev_wickets = snapshot.wickets;
+    dial_initialization_complete = true;
+    bootToScoreMs = millis();
+    M5.Lcd.printf("Restored %d/%d (%d)\n", prev_runs, prev_wickets, prev_overs);
+    Serial.printf("Restored dials from RTC memory in %lu ms (boot %lu, previous boot to score: %lu ms)\n",
+                  bootToScoreMs, (unsigned long)snapshot.bootCount, (unsigned long)snapshot.lastBootToScoreMs);
+  }
+
   for (int i = 0; i < NUM_DIALS; i++)
   {
-    labels[i] = "Dial " + String(i + 1) + " ";
-    ids[i] = "dial_" + String(i + 1);
+    const char *group;
+    const char *groupId;
+    int pos;
     if (i < 3)
     {
-      String pos = String(i + 1);
-      labels[i] += "Runs Digit " + pos + ":";
-      ids[i] += "_runs_" + pos;
+      group = "Runs";
+      groupId = "runs";
+      pos = i + 1;
     }
-    else if ((i >= 3) && (i < 6))
+    else if (i < 6)
     {
-      String pos = String(i - 3);
-      labels[i] += "Overs Digit " + pos + ":";
-      ids[i] += "_overs_" + pos;
+      group = "Overs";
+      groupId = "overs";
+      pos = i - 3;
     }
-    else if ((i >= 6) && (i < 8))
+    else
     {
-      String pos = String(i - 6);
-      labels[i] += "Wickets Digit " + String(i - 6) + ":";
-      ids[i] += "_wickets_" + pos;
+      group = "Wickets";
+      groupId = "wickets";
+      pos = i - 6;
     }
-    Serial.println("Label: " + labels[i]);
-    Serial.println("ID: " + ids[i]);
-    internalClockPos[i] = new IotWebConfNumberParameter(labels[i].c_str(), ids[i].c_str(), internalClockPosValue[i], NUMBER_LEN, "0", "0..9", "min='0' max='9' step='1'");
+    snprintf(labels[i], STRING_LEN, "Dial %d %s Digit %d:", i + 1, group, pos);
+    snprintf(ids[i], NUMBER_LEN, "dial_%d_%s_%d", i + 1, groupId, pos);
+    internalClockPos[i] = new IotWebConfNumberParameter(labels[i], ids[i], internalClockPosValue[i], NUMBER_LEN, "0", "0..9", "min='0' max='9' step='1'");
     sbSettings.addItem(internalClockPos[i]);
   }
 
@@ -373,6 +512,11 @@ void setup()
   sbSettings.addItem(&tournamentId);
   sbSettings.addItem(&clubId);
   sbSettings.addItem(&matchId);
+  sbSettings.addItem(&boardRole);
+  sbSettings.addItem(&backupHost);
+  sbSettings.addItem(&backupPort);
+  sbSettings.addItem(&hedgePercentile);
+  sbSettings.addItem(&proxyHost);
 
   iotWebConf.setStatusPin(STATUS_PIN);
   iotWebConf.setConfigPin(CONFIG_PIN);
@@ -380,6 +524,13 @@ void setup()
   iotWebConf.setConfigSavedCallback(&configSaved);
   iotWebConf.setFormValidator(&formValidator);
   iotWebConf.getApTimeoutParameter()->visible = true;
+  if (restoredFromRtc)
+  {
+    // The board was already configured and running: connect to WiFi straight away
+    // instead of first offering the access point portal for the AP timeout.
+    // The config pages stay reachable on the board's WiFi address.
+    iotWebConf.skipApStartup();
+  }
 
   // -- Initializing the configuration.
   Serial.println("initializing iotwebconf...");
@@ -387,39 +538,78 @@ void setup()
   iotWebConf.init();
   Serial.println("iotwebconf initialized...");
 
-  // Serial.printf("Prev Position =  %d \n", prevPos);
-
-  Serial.println("initializing dials...");
-
-  for (int i = 0; i < NUM_DIALS; i++)
+  if (restoredFromRtc)
   {
-    int value = atoi(internalClockPosValue[i]);
-    Serial.printf("dials %d initializing...\n", i);
-
-    dials[i].init(i, &pwm, value);
-    Serial.printf("dials %d initialized...\n", i);
-
-    // calculate the number of runs using the first 3 digits of the internal clock position
-    if (i < 3)
+    // RTC memory is newer than the saved config, so save it once things settle
+    for (int i = 0; i < NUM_DIALS; i++)
     {
-      prev_runs += value * pow(10, (i));
+      if (atoi(internalClockPosValue[i]) != dials[i].getPos())
+      {
+        config_updated = true;
+      }
     }
-    // calculate the number of overs using the 4th - 6th digits of the internal clock position
-    else if ((i >= 3) && (i < 6))
+    if (config_updated)
     {
-      prev_overs += value * pow(10, (i - 3));
+      tSaveConfig.restartDelayed(CONFIG_QUIET_PERIOD * TASK_MILLISECOND);
     }
-    // calculate the number of wickets using the 7th - 8th digits of the internal clock position
-    else if ((i >= 6) && (i < 8))
+  }
+  else
+  {
+    Serial.println("initializing dials...");
+
+    for (int i = 0; i < NUM_DIALS; i++)
     {
-      prev_wickets += value * pow(10, (i - 6));
+      int value = atoi(internalClockPosValue[i]);
+      dials[i].init(i, &pwm, value);
+
+      // calculate the number of runs using the first 3 digits of the internal clock position
+      if (i < 3)
+      {
+        prev_runs += value * pow(10, (i));
+      }
+      // calculate the number of overs using the 4th - 6th digits of the internal clock position
+      else if ((i >= 3) && (i < 6))
+      {
+        prev_overs += value * pow(10, (i - 3));
+      }
+      // calculate the number of wickets using the 7th - 8th digits of the internal clock position
+      else if ((i >= 6) && (i < 8))
+      {
+        prev_wickets += value * pow(10, (i - 6));
+      }
     }
+    dial_initialization_complete = true;
+    saveDialSnapshot();
+    Serial.println("dials initialized...");
+  }
+
+  BoardRole role = boardRoleFromName(boardRoleValue);
+  if (role == ROLE_FOLLOWER)
+  {
+    tGetScore.disable();
+  }
+  if (role != ROLE_STANDALONE)
+  {
+    tListenScore.enable();
   }
-  dial_initialization_complete = true;
-  Serial.println("dials initialized...");
 
   // -- Set up required URL handlers on the web server.
   server.on("/", handleRoot);
+  server.on("/telemetry", []
+            {
+              String json;
+              memoryTelemetry.exportJson(json);
+              server.send(200, "application/json", json);
+            });
+#ifdef _I2C_TRACE_
+  // -- Trace of the PCA9685 transactions, replay it with tools/i2c_replay.cpp
+  server.on("/i2c-trace", []
+            {
+              StreamString csv;
+              i2cTrace.exportCsv(csv);
+              server.send(200, "text/csv", csv);
+            });
+#endif
   server.on("/config", []
             { iotWebConf.handleConfig(); });
   server.onNotFound([]()
@@ -428,7 +618,49 @@ void setup()
   Serial.println("Setup completed. Ready.");
 }
 
+// Serial commands, one per line:
+//   clockcal <clockA> <clockB>  calibrates the clock mechanism wired to these PWM channels,
+//                               confirmed with the M5 buttons, and saves its timing in NVS
+//                               where ClockDial::init() loads it. The scoreboard pauses
+//                               until it is done.
+#define SERIAL_LINE_LEN 32
 char rx_byte = 0;
+char serialLine[SERIAL_LINE_LEN];
+int serialLineLen = 0;
+
+void handleSerialCommand()
+{
+  while (Serial.available() > 0)
+  {
+    rx_byte = Serial.read();
+    if (rx_byte != '\n' && rx_byte != '\r')
+    {
+      if (serialLineLen < SERIAL_LINE_LEN - 1)
+      {
+        serialLine[serialLineLen++] = rx_byte;
+      }
+      continue;
+    }
+    serialLine[serialLineLen] = '\0';
+    serialLineLen = 0;
+    int clockA, clockB;
+    if (sscanf(serialLine, "clockcal %d %d", &clockA, &clockB) == 2)
+    {
+      if (clockA == clockB || min(clockA, clockB) < NUM_DIALS || max(clockA, clockB) >= pwm.getChannelCount())
+      {
+        Serial.printf("Clock channels must be two of %d..%d, the others drive the score dials\n", NUM_DIALS, pwm.getChannelCount() - 1);
+      }
+      else
+      {
+        calibrateClockDial(pwm, clockA, clockB);
+      }
+    }
+    else if (serialLine[0])
+    {
+      Serial.printf("Unknown command: %s\n", serialLine);
+    }
+  }
+}
 
 // Main loop
 void loop()
@@ -442,9 +674,19 @@ void loop()
       M5.Lcd.println(clubIdValue);
       M5.Lcd.println(matchIdValue);
       // Serial.println("Executing scheduled task.");
+      if (!wifiWasConnected)
+      {
+        wifiWasConnected = true;
+        wifiReconnected = true;
+      }
       ts.execute();
     }
+  else
+    {
+      wifiWasConnected = false;
+    }
 
+  handleSerialCommand();
   iotWebConf.doLoop();
 }
 
@@ -466,6 +708,13 @@ void handleRoot()
   s += atoi(clubIdValue);
   s += "<li>Match ID: ";
   s += atoi(matchIdValue);
+  s += "<li>Boot to first score: ";
+  s += bootToScoreMs;
+  s += " ms";
+  s += restoredFromRtc ? " (restored after reset)" : "";
+  s += "<li>Boot to first fetch: ";
+  s += bootToFetchMs;
+  s += " ms</ul>";
   s += "Go to <a href='config'>configure page</a> to change values.";
   s += "</body></html>\n";
   // int prevPos = atoi(internalClockPosValue);
@@ -476,6 +725,8 @@ void handleRoot()
 void configSaved()
 {
   int desPos = 0;
+  // the positions in RTC memory are older than the ones just saved from the portal
+  invalidateBootSnapshot();
   if (dial_initialization_complete) {
     for (int i = 0; i < NUM_DIALS; i++)
     {
@@ -484,6 +735,10 @@ void configSaved()
       Serial.printf("New Desired Position =  %d \n", desPos);
       dials[i].setPos(desPos);
     }
+    pwm.flush();
+    saveDialSnapshot();
+    // the portal already saved these positions, a pending save must not write older ones
+    config_updated = false;
 
     Serial.println("Configuration was updated.");
   } else {
@@ -0,0 +1,89 @@
+/*
+Host stand-in for the Arduino core used by the native tests
+*/
+
+#ifndef _HOST_ARDUINO_H
+#define _HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "Print.h"
+
+using std::max;
+using std::min;
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// The tests can stop the clock: millis() then only moves when the code under test
+// calls delay() or the test advances it, so a timeout is checked without waiting for it.
+struct HostClock
+{
+    static inline std::atomic<bool> fake{false};
+    static inline std::atomic<unsigned long> fakeMs{0};
+
+    static unsigned long realMicros()
+    {
+        static const auto start = std::chrono::steady_clock::now();
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+inline void hostUseFakeClock(bool fake)
+{
+    HostClock::fakeMs = 0;
+    HostClock::fake = fake;
+}
+
+inline void hostAdvance(unsigned long ms)
+{
+    HostClock::fakeMs += ms;
+}
+
+inline unsigned long millis()
+{
+    return HostClock::fake ? HostClock::fakeMs.load() : HostClock::realMicros() / 1000;
+}
+
+inline unsigned long micros()
+{
+    return HostClock::fake ? HostClock::fakeMs.load() * 1000 : HostClock::realMicros();
+}
+
+inline void delay(unsigned long ms)
+{
+    if (HostClock::fake)
+    {
+        hostAdvance(ms);
+    }
+    else
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+inline void yield()
+{
+}
+
+class HardwareSerial : public Print
+{
+public:
+    void begin(unsigned long) {}
+    using Print::write;
+    size_t write(uint8_t c) override
+    {
+        return fputc(c, stdout) == EOF ? 0 : 1;
+    }
+};
+
+inline HardwareSerial Serial;
+
+#endif
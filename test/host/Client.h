@@ -0,0 +1,24 @@
+/*
+Host stand-in for the Arduino Client interface
+*/
+
+#ifndef _HOST_CLIENT_H
+#define _HOST_CLIENT_H
+
+#include "Print.h"
+
+class Client : public Print
+{
+public:
+    using Print::write;
+    virtual int connect(const char *host, uint16_t port) = 0;
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size) = 0;
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual void flush() {}
+    virtual void stop() = 0;
+    virtual uint8_t connected() = 0;
+};
+
+#endif
@@ -0,0 +1,130 @@
+/*
+TCP server on a loopback port for host tests, each connection served on its own thread
+*/
+
+#ifndef _HOST_LOOPBACK_SERVER_H
+#define _HOST_LOOPBACK_SERVER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "WiFiClient.h"
+
+/// @brief Listens on 127.0.0.1 on a free port. A subclass answers connections in
+/// serve() once it calls start(), and calls stop() in its destructor, before its own
+/// members go away. The connection is closed when serve() returns.
+class LoopbackServer
+{
+public:
+    LoopbackServer(int backlog = 8)
+    {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        bind(_fd, (sockaddr *)&addr, sizeof(addr));
+        socklen_t len = sizeof(addr);
+        getsockname(_fd, (sockaddr *)&addr, &len);
+        port = ntohs(addr.sin_port);
+        listen(_fd, backlog);
+    }
+
+    LoopbackServer(const LoopbackServer &) = delete;
+    LoopbackServer &operator=(const LoopbackServer &) = delete;
+
+    virtual ~LoopbackServer()
+    {
+        stop();
+        close(_fd);
+    }
+
+    uint16_t port;
+
+protected:
+    virtual void serve(int client) = 0;
+
+    void start()
+    {
+        _thread = std::thread([this]
+                              { run(); });
+    }
+
+    /// @brief Stops accepting and waits for the connections being served
+    void stop()
+    {
+        _stop = true;
+        if (_thread.joinable())
+        {
+            _thread.join();
+        }
+        for (std::thread &t : _connections)
+        {
+            t.join();
+        }
+        _connections.clear();
+    }
+
+    /// @brief Reads a request up to the blank line after its headers
+    /// @return false if the client hung up first
+    static bool readRequest(int client, std::string &request)
+    {
+        char buf[512];
+        while (request.find("\r\n\r\n") == std::string::npos)
+        {
+            ssize_t n = recv(client, buf, sizeof(buf), 0);
+            if (n <= 0)
+            {
+                return false;
+            }
+            request.append(buf, n);
+        }
+        return true;
+    }
+
+    /// @brief Value of header name in request, "" if it is not there
+    static std::string header(const std::string &request, const char *name)
+    {
+        std::string key = std::string("\r\n") + name + ": ";
+        size_t at = request.find(key);
+        if (at == std::string::npos)
+        {
+            return "";
+        }
+        at += key.size();
+        return request.substr(at, request.find("\r\n", at) - at);
+    }
+
+    static void reply(int client, const std::string &response)
+    {
+        send(client, response.data(), response.size(), MSG_NOSIGNAL);
+    }
+
+private:
+    void run()
+    {
+        while (!_stop)
+        {
+            pollfd p = {_fd, POLLIN, 0};
+            if (poll(&p, 1, 20) == 1)
+            {
+                int client = accept(_fd, nullptr, nullptr);
+                _connections.emplace_back([this, client]
+                                          {
+                                              serve(client);
+                                              close(client);
+                                          });
+            }
+        }
+    }
+
+    int _fd;
+    std::atomic<bool> _stop{false};
+    std::thread _thread;
+    std::vector<std::thread> _connections;
+};
+
+#endif
@@ -0,0 +1,138 @@
+/*
+Host stand-in for WiFiClient, a plain TCP socket
+*/
+
+#ifndef _HOST_WIFI_CLIENT_H
+#define _HOST_WIFI_CLIENT_H
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "Arduino.h"
+#include "Client.h"
+
+class WiFiClient : public Client
+{
+public:
+    WiFiClient() {}
+    WiFiClient(const WiFiClient &) = delete;
+    WiFiClient &operator=(const WiFiClient &) = delete;
+    ~WiFiClient() { stop(); }
+
+    int connect(const char *host, uint16_t port) override
+    {
+        return connect(host, port, 3000);
+    }
+
+    /// @brief Non-blocking connect bounded by timeoutMs, like the ESP32 core
+    virtual int connect(const char *host, uint16_t port, int32_t timeoutMs)
+    {
+        stop();
+        addrinfo hints = {};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo *result;
+        char service[8];
+        snprintf(service, sizeof(service), "%u", port);
+        if (getaddrinfo(host, service, &hints, &result) != 0)
+        {
+            return 0;
+        }
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        fcntl(_fd, F_SETFL, O_NONBLOCK);
+        int rc = ::connect(_fd, result->ai_addr, result->ai_addrlen);
+        freeaddrinfo(result);
+        if (rc < 0)
+        {
+            pollfd p = {_fd, POLLOUT, 0};
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (poll(&p, 1, timeoutMs) != 1 || getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0)
+            {
+                stop();
+                return 0;
+            }
+        }
+        _closed = false;
+        return 1;
+    }
+
+    using Client::write;
+    size_t write(uint8_t c) override
+    {
+        return write(&c, 1);
+    }
+
+    size_t write(const uint8_t *buffer, size_t size) override
+    {
+        size_t sent = 0;
+        while (_fd >= 0 && sent < size)
+        {
+            ssize_t n = send(_fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+            if (n > 0)
+            {
+                sent += n;
+            }
+            else if (n < 0 && errno == EAGAIN)
+            {
+                pollfd p = {_fd, POLLOUT, 0};
+                poll(&p, 1, 100);
+            }
+            else
+            {
+                break;
+            }
+        }
+        return sent;
+    }
+
+    int available() override
+    {
+        if (_fd < 0)
+        {
+            return 0;
+        }
+        int n = 0;
+        ioctl(_fd, FIONREAD, &n);
+        if (n == 0)
+        {
+            char c;
+            ssize_t peeked = recv(_fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+            _closed = peeked == 0 || (peeked < 0 && errno != EAGAIN && errno != EWOULDBLOCK);
+        }
+        return n;
+    }
+
+    int read() override
+    {
+        uint8_t c;
+        return _fd >= 0 && recv(_fd, &c, 1, MSG_DONTWAIT) == 1 ? c : -1;
+    }
+
+    void stop() override
+    {
+        if (_fd >= 0)
+        {
+            close(_fd);
+            _fd = -1;
+        }
+        _closed = true;
+    }
+
+    uint8_t connected() override
+    {
+        return _fd >= 0 && (available() > 0 || !_closed);
+    }
+
+private:
+    int _fd = -1;
+    bool _closed = true;
+};
+
+#endif
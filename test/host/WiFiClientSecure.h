@@ -0,0 +1,20 @@
+/*
+Host stand-in for WiFiClientSecure, without TLS
+*/
+
+#ifndef _HOST_WIFI_CLIENT_SECURE_H
+#define _HOST_WIFI_CLIENT_SECURE_H
+
+#include "WiFiClient.h"
+
+// Connects in plain TCP. Tests derive from it and override connect() to play the
+// TCP connect and the TLS handshake, which the ESP32 core does in one call.
+class WiFiClientSecure : public WiFiClient
+{
+public:
+    void setInsecure() {}
+    void setHandshakeTimeout(unsigned long seconds) { handshakeTimeout = seconds; }
+    unsigned long handshakeTimeout = 0;
+};
+
+#endif
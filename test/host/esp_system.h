@@ -0,0 +1,17 @@
+/*
+Host stand-in for the ESP-IDF system functions
+*/
+
+#ifndef _HOST_ESP_SYSTEM_H
+#define _HOST_ESP_SYSTEM_H
+
+#include <stdint.h>
+#include <random>
+
+inline uint32_t esp_random()
+{
+    static std::random_device random;
+    return random();
+}
+
+#endif
@@ -0,0 +1,46 @@
+/*
+Host stand-in for the FreeRTOS tasks, on std::thread
+*/
+
+#ifndef _HOST_FREERTOS_H
+#define _HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <thread>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef void *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *);
+
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffu
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// Stack size and priority mean nothing on the host, the task is a detached thread
+inline BaseType_t xTaskCreate(TaskFunction_t task, const char *, uint32_t, void *arg, int, TaskHandle_t *handle)
+{
+    std::thread(task, arg).detach();
+    if (handle)
+    {
+        *handle = nullptr;
+    }
+    return pdPASS;
+}
+
+// The firmware's tasks call vTaskDelete(NULL) as their last statement, returning
+// from the thread function right after it ends the thread just the same
+inline void vTaskDelete(TaskHandle_t)
+{
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+#endif
@@ -0,0 +1,78 @@
+/*
+Host stand-in for the FreeRTOS event groups
+*/
+
+#ifndef _HOST_EVENT_GROUPS_H
+#define _HOST_EVENT_GROUPS_H
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include "FreeRTOS.h"
+
+typedef uint32_t EventBits_t;
+
+struct HostEventGroup
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    EventBits_t bits = 0;
+};
+
+typedef HostEventGroup *EventGroupHandle_t;
+
+inline EventGroupHandle_t xEventGroupCreate()
+{
+    return new HostEventGroup();
+}
+
+inline void vEventGroupDelete(EventGroupHandle_t group)
+{
+    delete group;
+}
+
+inline EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    std::lock_guard<std::mutex> guard(group->lock);
+    group->bits |= bits;
+    group->changed.notify_all();
+    return group->bits;
+}
+
+inline EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    std::lock_guard<std::mutex> guard(group->lock);
+    EventBits_t before = group->bits;
+    group->bits &= ~bits;
+    return before;
+}
+
+inline EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    std::lock_guard<std::mutex> guard(group->lock);
+    return group->bits;
+}
+
+/// @brief Returns the bits as they were when the wait ended, like FreeRTOS
+inline EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit, BaseType_t waitForAll, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> guard(group->lock);
+    auto done = [&]
+    { return waitForAll ? (group->bits & bits) == bits : (group->bits & bits) != 0; };
+    if (ticks == portMAX_DELAY)
+    {
+        group->changed.wait(guard, done);
+    }
+    else
+    {
+        group->changed.wait_for(guard, std::chrono::milliseconds(ticks), done);
+    }
+    EventBits_t result = group->bits;
+    if (clearOnExit && done())
+    {
+        group->bits &= ~bits;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,285 @@
+// FetchBudget tests
+//
+// Runs on the fake clock of test/host/Arduino.h: readLine() waits with delay(1),
+// which advances the clock, so a server that stalls or trickles for seconds is
+// played in microseconds and every deadline is checked to the millisecond.
+//   pio test -e native -f test_fetch_budget
+
+#include <limits.h>
+#include <unity.h>
+#include <vector>
+#include "FetchBudget.h"
+
+#define TEST_BUDGET_MS 10000 // connect 2000, TLS 3000, headers 1500, body 3500
+
+// Peer on the fake clock: every byte becomes readable at its own time
+class ScriptedClient : public Client
+{
+public:
+    void sendAt(unsigned long atMs, const char *data)
+    {
+        while (*data)
+        {
+            _bytes.push_back({atMs, *data++});
+        }
+    }
+
+    /// @brief One byte every everyMs, starting at startMs
+    void trickle(unsigned long startMs, unsigned long everyMs, const char *data)
+    {
+        for (unsigned long at = startMs; *data; at += everyMs)
+        {
+            _bytes.push_back({at, *data++});
+        }
+    }
+
+    void closeAt(unsigned long atMs) { _closeAt = atMs; }
+
+    int connect(const char *, uint16_t) override { return 1; }
+    size_t write(uint8_t) override { return 1; }
+    size_t write(const uint8_t *, size_t size) override { return size; }
+    void stop() override { _closeAt = 0; }
+
+    int available() override
+    {
+        int n = 0;
+        for (size_t i = _next; i < _bytes.size() && _bytes[i].first <= millis(); i++)
+        {
+            n++;
+        }
+        return n;
+    }
+
+    int read() override
+    {
+        return available() ? (uint8_t)_bytes[_next++].second : -1;
+    }
+
+    uint8_t connected() override
+    {
+        return millis() < _closeAt || available() > 0;
+    }
+
+private:
+    std::vector<std::pair<unsigned long, char>> _bytes;
+    size_t _next = 0;
+    unsigned long _closeAt = ULONG_MAX;
+};
+
+// Plays the combined TCP connect and TLS handshake of the ESP32 WiFiClientSecure
+class ScriptedTls : public WiFiClientSecure
+{
+public:
+    unsigned long takesMs = 0;
+    bool succeeds = true;
+    FetchBudget *cancels = nullptr; // cancelled by "another task" while connecting
+    int32_t timeoutMs = -1;
+    bool stopped = false;
+
+    int connect(const char *, uint16_t, int32_t timeout) override
+    {
+        timeoutMs = timeout;
+        hostAdvance(takesMs);
+        if (cancels)
+        {
+            cancels->cancel();
+        }
+        return succeeds;
+    }
+
+    void stop() override { stopped = true; }
+};
+
+class ScriptedTcp : public WiFiClient
+{
+public:
+    unsigned long takesMs = 0;
+
+    int connect(const char *, uint16_t, int32_t) override
+    {
+        hostAdvance(takesMs);
+        return 0;
+    }
+};
+
+void setUp()
+{
+    hostUseFakeClock(true);
+}
+
+void tearDown()
+{
+    hostUseFakeClock(false);
+}
+
+void test_connect_refused_is_connect_failed()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedTls client;
+    client.takesMs = 30;
+    client.succeeds = false;
+    TEST_ASSERT_FALSE(budget.connect(client, "example.com", 443));
+    TEST_ASSERT_EQUAL(FetchError::ConnectFailed, budget.getError());
+    TEST_ASSERT_EQUAL(2000, client.timeoutMs);
+    TEST_ASSERT_EQUAL(3, client.handshakeTimeout);
+}
+
+void test_tcp_stall_is_connect_timeout()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedTls client;
+    client.takesMs = 2000;
+    client.succeeds = false;
+    TEST_ASSERT_FALSE(budget.connect(client, "example.com", 443));
+    TEST_ASSERT_EQUAL(FetchError::ConnectTimeout, budget.getError());
+}
+
+void test_handshake_stall_is_tls_timeout()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedTls client;
+    client.takesMs = 2000 + 3000;
+    client.succeeds = false;
+    TEST_ASSERT_FALSE(budget.connect(client, "example.com", 443));
+    TEST_ASSERT_EQUAL(FetchError::TlsTimeout, budget.getError());
+}
+
+void test_handshake_past_overall_deadline_is_tls_timeout()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    hostAdvance(7000);
+    ScriptedTls client;
+    client.takesMs = 3000;
+    TEST_ASSERT_FALSE(budget.connect(client, "example.com", 443));
+    TEST_ASSERT_EQUAL(FetchError::TlsTimeout, budget.getError());
+    TEST_ASSERT_TRUE(client.stopped);
+}
+
+void test_cancel_while_connecting()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedTls client;
+    client.takesMs = 100;
+    client.cancels = &budget;
+    TEST_ASSERT_FALSE(budget.connect(client, "example.com", 443));
+    TEST_ASSERT_EQUAL(FetchError::Cancelled, budget.getError());
+    TEST_ASSERT_TRUE(client.stopped);
+}
+
+void test_plain_tcp_stall_is_connect_timeout()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedTcp client;
+    client.takesMs = 2000;
+    TEST_ASSERT_FALSE(budget.connect(client, "example.com", 80));
+    TEST_ASSERT_EQUAL(FetchError::ConnectTimeout, budget.getError());
+}
+
+void test_silent_server_is_header_timeout()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    char line[64];
+    budget.startPhase(FetchPhase::Headers);
+    TEST_ASSERT_EQUAL(FetchError::HeaderTimeout, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL(1500, budget.elapsed());
+}
+
+void test_trickling_headers_stop_at_header_deadline()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    client.sendAt(0, "HTTP/1.1 200 OK\r\n");
+    client.trickle(10, 100, "Server: a-very-slow-server-that-never-ends-its-header-line");
+    char line[64];
+    budget.startPhase(FetchPhase::Headers);
+    TEST_ASSERT_EQUAL(FetchError::None, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r", line);
+    TEST_ASSERT_EQUAL(FetchError::HeaderTimeout, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL(1500, budget.elapsed());
+}
+
+void test_trickling_body_is_body_timeout()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    client.sendAt(0, "\r\n");
+    client.trickle(500, 100, "<html><body>one byte at a time, never a newline, for much longer than the body share</body>");
+    char line[256];
+    budget.startPhase(FetchPhase::Headers);
+    TEST_ASSERT_EQUAL(FetchError::None, budget.readLine(client, line, sizeof(line)));
+    budget.startPhase(FetchPhase::Body);
+    TEST_ASSERT_EQUAL(FetchError::BodyTimeout, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL(3500, budget.elapsed());
+    TEST_ASSERT_EQUAL(FetchError::BodyTimeout, budget.getError());
+}
+
+void test_phase_is_capped_by_overall_deadline()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    char line[64];
+    hostAdvance(9000);
+    budget.startPhase(FetchPhase::Body);
+    TEST_ASSERT_EQUAL(1000, budget.phaseRemaining());
+    TEST_ASSERT_EQUAL(FetchError::BodyTimeout, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL(TEST_BUDGET_MS, budget.elapsed());
+}
+
+void test_cancel_stops_read()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    char line[64];
+    budget.startPhase(FetchPhase::Body);
+    budget.cancel();
+    TEST_ASSERT_EQUAL(FetchError::Cancelled, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL(0, budget.elapsed());
+}
+
+void test_byte_limit()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    client.sendAt(0, "0123456789abcdef\n");
+    char line[64];
+    budget.startPhase(FetchPhase::Body);
+    budget.setByteLimit(10);
+    TEST_ASSERT_EQUAL(FetchError::ByteLimit, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL(10, budget.bytesRead());
+}
+
+void test_lines_then_closed()
+{
+    FetchBudget budget(TEST_BUDGET_MS);
+    ScriptedClient client;
+    client.sendAt(0, "first\nlast line is truncated");
+    client.closeAt(5);
+    char line[10];
+    budget.startPhase(FetchPhase::Body);
+    TEST_ASSERT_EQUAL(FetchError::None, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("first", line);
+    TEST_ASSERT_EQUAL(FetchError::None, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_EQUAL_STRING("last line", line);
+    TEST_ASSERT_EQUAL(FetchError::Closed, budget.readLine(client, line, sizeof(line)));
+    TEST_ASSERT_TRUE(budget.ok());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_connect_refused_is_connect_failed);
+    RUN_TEST(test_tcp_stall_is_connect_timeout);
+    RUN_TEST(test_handshake_stall_is_tls_timeout);
+    RUN_TEST(test_handshake_past_overall_deadline_is_tls_timeout);
+    RUN_TEST(test_cancel_while_connecting);
+    RUN_TEST(test_plain_tcp_stall_is_connect_timeout);
+    RUN_TEST(test_silent_server_is_header_timeout);
+    RUN_TEST(test_trickling_headers_stop_at_header_deadline);
+    RUN_TEST(test_trickling_body_is_body_timeout);
+    RUN_TEST(test_phase_is_capped_by_overall_deadline);
+    RUN_TEST(test_cancel_stops_read);
+    RUN_TEST(test_byte_limit);
+    RUN_TEST(test_lines_then_closed);
+    return UNITY_END();
+}
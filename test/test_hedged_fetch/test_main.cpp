@@ -0,0 +1,263 @@
+// HedgedFetch tests
+//
+// Two scorecard sources served over plain HTTP on loopback ports, each answering
+// after its own delay, fetched with the real ScoreFetcher and worker tasks (threads
+// on the host). Checks when the backup is asked, that the first valid score wins,
+// that the loser is cancelled and the counters. Runs on the real clock, about 10 s.
+//   pio test -e native -f test_hedged_fetch
+
+#include <unity.h>
+#include "HedgedFetch.h"
+#include "LoopbackServer.h"
+
+#define PAGE_WITH_SCORE(score) "<html><head>\n<meta name='description' content='A 99/9(20.0 overs) B " score "(15.0 overs)'/>\n</head></html>\n"
+#define PAGE_WITHOUT_SCORE "<html><head>\n<title>No such match</title>\n</head></html>\n"
+#define SCORECARD "/NACL/viewScorecard.do?matchId=1&clubId=2"
+
+static unsigned long nowMs()
+{
+    return millis();
+}
+
+// Answers every request after delayMs, or notices that the client hung up first
+class DelayedServer : public LoopbackServer
+{
+public:
+    DelayedServer(unsigned long delayMs, const char *page) : delayMs(delayMs), page(page)
+    {
+        start();
+    }
+
+    ~DelayedServer() { stop(); }
+
+    std::atomic<unsigned long> delayMs;
+    std::string page;
+    std::atomic<int> requests{0};
+    std::atomic<int> answered{0};
+    std::atomic<int> abandoned{0}; // the client closed before the answer was due
+    std::atomic<unsigned long> lastRequestMs{0};
+
+private:
+    void serve(int client) override
+    {
+        std::string request;
+        if (!readRequest(client, request))
+        {
+            return;
+        }
+        requests++;
+        lastRequestMs = nowMs();
+        unsigned long due = nowMs() + delayMs;
+        char buf[64];
+        while (nowMs() < due)
+        {
+            // a cancelled fetch closes its connection, which shows up as readable EOF
+            pollfd p = {client, POLLIN, 0};
+            if (poll(&p, 1, 10) == 1 && recv(client, buf, sizeof(buf), MSG_DONTWAIT) == 0)
+            {
+                abandoned++;
+                return;
+            }
+        }
+        reply(client, "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: " + std::to_string(page.size()) + "\r\nConnection: close\r\n\r\n" + page);
+        answered++;
+    }
+};
+
+// A port whose accept queue is full: connects to it hang until their timeout, the
+// one blocking step a cancel cannot cut short
+class StuckServer : public LoopbackServer
+{
+public:
+    StuckServer() : LoopbackServer(0)
+    {
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons(port);
+        for (int i = 0; i < 8; i++)
+        {
+            int fd = socket(AF_INET, SOCK_STREAM, 0);
+            fcntl(fd, F_SETFL, O_NONBLOCK);
+            ::connect(fd, (sockaddr *)&addr, sizeof(addr));
+            _fillers.push_back(fd);
+            pollfd p = {fd, POLLOUT, 0};
+            if (poll(&p, 1, 100) == 0)
+            {
+                break; // this one hangs, so will the next
+            }
+        }
+    }
+
+    ~StuckServer()
+    {
+        for (int fd : _fillers)
+        {
+            close(fd);
+        }
+    }
+
+private:
+    void serve(int) override {} // never started, nothing is accepted
+
+    std::vector<int> _fillers;
+};
+
+static void waitIdle(HedgedFetch &hedged)
+{
+    unsigned long until = nowMs() + FETCH_BUDGET_MS;
+    while ((hedged.isBusy(0) || hedged.isBusy(1)) && nowMs() < until)
+    {
+        delay(10);
+    }
+}
+
+/// @brief Polls until the primary latency history is full of fast answers
+static void warmUp(HedgedFetch &hedged, DelayedServer &primary)
+{
+    unsigned long delayMs = primary.delayMs;
+    primary.delayMs = 20;
+    MatchDetails details;
+    for (int i = 0; i < HEDGE_MIN_SAMPLES; i++)
+    {
+        TEST_ASSERT_TRUE(hedged.fetch(SCORECARD, details));
+    }
+    primary.delayMs = delayMs;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_fast_primary_is_not_hedged()
+{
+    DelayedServer primaryServer(20, PAGE_WITH_SCORE("123/4"));
+    DelayedServer backupServer(20, PAGE_WITH_SCORE("124/4"));
+    ScoreFetcher primary, backup;
+    HedgedFetch hedged(primary, backup);
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+
+    MatchDetails details;
+    TEST_ASSERT_TRUE(hedged.fetch(SCORECARD, details));
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+    TEST_ASSERT_EQUAL(4, details.getWickets());
+    TEST_ASSERT_EQUAL(0, hedged.getHedges());
+    TEST_ASSERT_EQUAL(1, hedged.getWins(0));
+    TEST_ASSERT_EQUAL(0, backupServer.requests.load());
+    // without latency history the backup waits for the default delay
+    TEST_ASSERT_EQUAL(HEDGE_DEFAULT_DELAY, hedged.hedgeDelay());
+    waitIdle(hedged);
+}
+
+void test_slow_primary_is_hedged_after_learned_delay()
+{
+    DelayedServer primaryServer(3000, PAGE_WITH_SCORE("123/4"));
+    DelayedServer backupServer(50, PAGE_WITH_SCORE("124/4"));
+    ScoreFetcher primary, backup;
+    HedgedFetch hedged(primary, backup);
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+    warmUp(hedged, primaryServer);
+    TEST_ASSERT_EQUAL(HEDGE_MIN_DELAY, hedged.hedgeDelay()); // fast answers, the floor applies
+
+    unsigned long started = nowMs();
+    MatchDetails details;
+    TEST_ASSERT_TRUE(hedged.fetch(SCORECARD, details));
+    unsigned long took = nowMs() - started;
+    TEST_ASSERT_EQUAL(124, details.getRuns());
+    TEST_ASSERT_EQUAL(1, hedged.getHedges());
+    TEST_ASSERT_EQUAL(1, hedged.getWins(1));
+    TEST_ASSERT_EQUAL(HEDGE_MIN_SAMPLES, hedged.getWins(0));
+
+    // the backup was asked once the hedge delay had passed, not before
+    unsigned long askedAfter = backupServer.lastRequestMs - started;
+    TEST_ASSERT_GREATER_OR_EQUAL(HEDGE_MIN_DELAY, askedAfter);
+    TEST_ASSERT_LESS_THAN(HEDGE_MIN_DELAY + 500, askedAfter);
+    TEST_ASSERT_LESS_THAN(1500, took);
+
+    // the primary was cancelled and hung up long before its answer was due
+    waitIdle(hedged);
+    TEST_ASSERT_EQUAL(1, primaryServer.abandoned.load());
+    TEST_ASSERT_EQUAL(HEDGE_MIN_SAMPLES, primaryServer.answered.load());
+}
+
+void test_invalid_primary_answer_does_not_win()
+{
+    DelayedServer primaryServer(20, PAGE_WITHOUT_SCORE);
+    DelayedServer backupServer(20, PAGE_WITH_SCORE("124/4"));
+    ScoreFetcher primary, backup;
+    HedgedFetch hedged(primary, backup);
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+
+    unsigned long started = nowMs();
+    MatchDetails details;
+    TEST_ASSERT_TRUE(hedged.fetch(SCORECARD, details));
+    // the backup is asked right away instead of after the hedge delay
+    TEST_ASSERT_LESS_THAN(HEDGE_DEFAULT_DELAY, nowMs() - started);
+    TEST_ASSERT_EQUAL(124, details.getRuns());
+    TEST_ASSERT_EQUAL(1, hedged.getHedges());
+    TEST_ASSERT_EQUAL(0, hedged.getWins(0));
+    TEST_ASSERT_EQUAL(1, hedged.getWins(1));
+    waitIdle(hedged);
+}
+
+void test_both_invalid_is_a_failure()
+{
+    DelayedServer primaryServer(20, PAGE_WITHOUT_SCORE);
+    DelayedServer backupServer(20, PAGE_WITHOUT_SCORE);
+    ScoreFetcher primary, backup;
+    HedgedFetch hedged(primary, backup);
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+
+    MatchDetails details;
+    TEST_ASSERT_FALSE(hedged.fetch(SCORECARD, details));
+    TEST_ASSERT_FALSE(details.isInitialized());
+    TEST_ASSERT_EQUAL(1, hedged.getFailures());
+    TEST_ASSERT_EQUAL(0, hedged.getWins(0) + hedged.getWins(1));
+    waitIdle(hedged);
+}
+
+void test_busy_fetcher_keeps_its_source()
+{
+    DelayedServer primaryServer(20, PAGE_WITH_SCORE("123/4"));
+    DelayedServer backupServer(20, PAGE_WITH_SCORE("124/4"));
+    StuckServer stuck;
+    ScoreFetcher primary, backup;
+    HedgedFetch hedged(primary, backup);
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+    warmUp(hedged, primaryServer);
+
+    // the primary hangs in connect, the backup wins and the primary is left running
+    hedged.setSources("127.0.0.1", stuck.port, "127.0.0.1", backupServer.port);
+    MatchDetails details;
+    TEST_ASSERT_TRUE(hedged.fetch(SCORECARD, details));
+    TEST_ASSERT_EQUAL(124, details.getRuns());
+    TEST_ASSERT_TRUE(hedged.isBusy(0));
+
+    // the next poll must not move the source under the running worker
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+    TEST_ASSERT_TRUE(primary.isSource("127.0.0.1", stuck.port));
+    hedged.print();
+
+    // once the worker stopped, the new source is taken
+    waitIdle(hedged);
+    TEST_ASSERT_FALSE(hedged.isBusy(0));
+    hedged.setSources("127.0.0.1", primaryServer.port, "127.0.0.1", backupServer.port);
+    TEST_ASSERT_TRUE(primary.isSource("127.0.0.1", primaryServer.port));
+    TEST_ASSERT_TRUE(hedged.fetch(SCORECARD, details));
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_fast_primary_is_not_hedged);
+    RUN_TEST(test_slow_primary_is_hedged_after_learned_delay);
+    RUN_TEST(test_invalid_primary_answer_does_not_win);
+    RUN_TEST(test_both_invalid_is_a_failure);
+    RUN_TEST(test_busy_fetcher_keeps_its_source);
+    return UNITY_END();
+}
@@ -0,0 +1,191 @@
+// ProxyFrame tests
+//
+// The byte layout shared by ProxyClient and tools/scoreproxy.cpp: every field at
+// the offset ProxyFrame.h documents, replies carrying only the fields in the
+// mask, and frames that are short, long or of another version rejected.
+//   pio test -e native -f test_proxy_frame
+
+#include <string.h>
+#include <unity.h>
+#include "ProxyFrame.h"
+
+static ProxyReply fullReply()
+{
+    ProxyReply reply = {};
+    reply.epoch = 0x1234;
+    reply.seq = 0x01020304;
+    reply.mask = PROXY_ALL;
+    reply.age = 0xbeef;
+    reply.runs = 0x0123;
+    reply.overs = 0x00c8;
+    reply.wickets = 7;
+    return reply;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+void test_request_round_trip()
+{
+    ProxyRequest request = {};
+    request.epoch = 0xabcd;
+    request.seq = 42;
+    request.matchId = 1234567;
+    request.clubId = 7654321;
+    strcpy(request.tournament, "NACL");
+    uint8_t buf[PROXY_REQUEST_MAX_LEN];
+    size_t len = encodeProxyRequest(request, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(19 + 4, len);
+    TEST_ASSERT_EQUAL('S', buf[0]);
+    TEST_ASSERT_EQUAL('P', buf[1]);
+    TEST_ASSERT_EQUAL(PROXY_VERSION, buf[2]);
+    TEST_ASSERT_EQUAL(PROXY_REQUEST, buf[3]);
+    TEST_ASSERT_EQUAL(0xab, buf[4]);
+    TEST_ASSERT_EQUAL(42, buf[9]);
+    TEST_ASSERT_EQUAL(4, buf[18]);
+
+    ProxyRequest decoded = {};
+    TEST_ASSERT_TRUE(decodeProxyRequest(buf, len, decoded));
+    TEST_ASSERT_EQUAL(0xabcd, decoded.epoch);
+    TEST_ASSERT_EQUAL(42, decoded.seq);
+    TEST_ASSERT_EQUAL(1234567, decoded.matchId);
+    TEST_ASSERT_EQUAL(7654321, decoded.clubId);
+    TEST_ASSERT_EQUAL_STRING("NACL", decoded.tournament);
+}
+
+void test_reply_round_trip_with_header_offsets()
+{
+    ProxyReply reply = fullReply();
+    uint8_t buf[PROXY_REPLY_MAX_LEN];
+    size_t len = encodeProxyReply(reply, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(PROXY_REPLY_MAX_LEN, len);
+
+    // big endian fields at the documented offsets
+    TEST_ASSERT_EQUAL(PROXY_REPLY, buf[3]);
+    TEST_ASSERT_EQUAL(0x12, buf[4]);
+    TEST_ASSERT_EQUAL(0x34, buf[5]);
+    TEST_ASSERT_EQUAL(0x01, buf[6]);
+    TEST_ASSERT_EQUAL(0x04, buf[9]);
+    TEST_ASSERT_EQUAL(PROXY_ALL, buf[10]);
+    TEST_ASSERT_EQUAL(0xbe, buf[11]);
+    TEST_ASSERT_EQUAL(0xef, buf[12]);
+    TEST_ASSERT_EQUAL(0x01, buf[PROXY_REPLY_HEADER_LEN]);
+    TEST_ASSERT_EQUAL(0x23, buf[PROXY_REPLY_HEADER_LEN + 1]);
+    TEST_ASSERT_EQUAL(7, buf[PROXY_REPLY_HEADER_LEN + 4]);
+
+    ProxyReply decoded = {};
+    TEST_ASSERT_TRUE(decodeProxyReply(buf, len, decoded));
+    TEST_ASSERT_EQUAL(0x1234, decoded.epoch);
+    TEST_ASSERT_EQUAL(0x01020304, decoded.seq);
+    TEST_ASSERT_EQUAL(PROXY_ALL, decoded.mask);
+    TEST_ASSERT_EQUAL(0xbeef, decoded.age);
+    TEST_ASSERT_EQUAL(0x0123, decoded.runs);
+    TEST_ASSERT_EQUAL(0x00c8, decoded.overs);
+    TEST_ASSERT_EQUAL(7, decoded.wickets);
+}
+
+void test_age_is_independent_of_the_score_fields()
+{
+    ProxyReply reply = fullReply();
+    reply.mask = 0;
+    reply.age = 65535;
+    uint8_t buf[PROXY_REPLY_MAX_LEN];
+    size_t len = encodeProxyReply(reply, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(PROXY_REPLY_HEADER_LEN, len);
+
+    ProxyReply decoded = {};
+    TEST_ASSERT_TRUE(decodeProxyReply(buf, len, decoded));
+    TEST_ASSERT_EQUAL(65535, decoded.age);
+    TEST_ASSERT_EQUAL(0, decoded.mask);
+
+    reply.age = 180;
+    len = encodeProxyReply(reply, buf, sizeof(buf));
+    TEST_ASSERT_TRUE(decodeProxyReply(buf, len, decoded));
+    TEST_ASSERT_EQUAL(180, decoded.age);
+}
+
+void test_partial_delta_leaves_other_fields()
+{
+    // only the overs and wickets changed since the board's seq
+    ProxyReply reply = fullReply();
+    reply.mask = PROXY_OVERS | PROXY_WICKETS;
+    reply.overs = 201;
+    reply.wickets = 8;
+    uint8_t buf[PROXY_REPLY_MAX_LEN];
+    size_t len = encodeProxyReply(reply, buf, sizeof(buf));
+    TEST_ASSERT_EQUAL(PROXY_REPLY_HEADER_LEN + 2 + 1, len);
+    TEST_ASSERT_EQUAL(0, buf[PROXY_REPLY_HEADER_LEN]);
+    TEST_ASSERT_EQUAL(201, buf[PROXY_REPLY_HEADER_LEN + 1]);
+    TEST_ASSERT_EQUAL(8, buf[PROXY_REPLY_HEADER_LEN + 2]);
+
+    // decoded into the score the board already has
+    ProxyReply board = {};
+    board.runs = 150;
+    board.overs = 195;
+    board.wickets = 7;
+    TEST_ASSERT_TRUE(decodeProxyReply(buf, len, board));
+    TEST_ASSERT_EQUAL(150, board.runs);
+    TEST_ASSERT_EQUAL(201, board.overs);
+    TEST_ASSERT_EQUAL(8, board.wickets);
+    TEST_ASSERT_EQUAL(0xbeef, board.age);
+}
+
+void test_short_long_and_foreign_frames_are_rejected()
+{
+    ProxyReply reply = fullReply();
+    uint8_t buf[PROXY_REPLY_MAX_LEN + 1];
+    size_t len = encodeProxyReply(reply, buf, sizeof(buf));
+    ProxyReply decoded = {};
+    TEST_ASSERT_FALSE(decodeProxyReply(buf, len - 1, decoded));
+    TEST_ASSERT_FALSE(decodeProxyReply(buf, PROXY_REPLY_HEADER_LEN - 1, decoded));
+    TEST_ASSERT_FALSE(decodeProxyReply(buf, len + 1, decoded));
+
+    // a version 1 reply, without the age field
+    buf[2] = 1;
+    TEST_ASSERT_FALSE(decodeProxyReply(buf, len, decoded));
+    buf[2] = PROXY_VERSION;
+    buf[10] = PROXY_ALL | 8; // unknown field
+    TEST_ASSERT_FALSE(decodeProxyReply(buf, len, decoded));
+    buf[10] = PROXY_ALL;
+    buf[1] = 'X';
+    TEST_ASSERT_FALSE(decodeProxyReply(buf, len, decoded));
+    buf[1] = PROXY_MAGIC1;
+    TEST_ASSERT_TRUE(decodeProxyReply(buf, len, decoded));
+
+    // a request is not a reply, and the other way round
+    ProxyRequest request = {};
+    uint8_t req[PROXY_REQUEST_MAX_LEN];
+    size_t reqLen = encodeProxyRequest(request, req, sizeof(req));
+    TEST_ASSERT_FALSE(decodeProxyReply(req, reqLen, decoded));
+    TEST_ASSERT_FALSE(decodeProxyRequest(buf, len, request));
+    TEST_ASSERT_FALSE(decodeProxyRequest(req, reqLen - 1, request));
+    req[2] = PROXY_VERSION - 1;
+    TEST_ASSERT_FALSE(decodeProxyRequest(req, reqLen, request));
+}
+
+void test_buffer_too_small_is_not_encoded()
+{
+    ProxyReply reply = fullReply();
+    uint8_t buf[PROXY_REPLY_MAX_LEN];
+    TEST_ASSERT_EQUAL(0, encodeProxyReply(reply, buf, PROXY_REPLY_MAX_LEN - 1));
+    ProxyRequest request = {};
+    strcpy(request.tournament, "NACL");
+    TEST_ASSERT_EQUAL(0, encodeProxyRequest(request, buf, 19 + 3));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_request_round_trip);
+    RUN_TEST(test_reply_round_trip_with_header_offsets);
+    RUN_TEST(test_age_is_independent_of_the_score_fields);
+    RUN_TEST(test_partial_delta_leaves_other_fields);
+    RUN_TEST(test_short_long_and_foreign_frames_are_rejected);
+    RUN_TEST(test_buffer_too_small_is_not_encoded);
+    return UNITY_END();
+}
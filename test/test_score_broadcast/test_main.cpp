@@ -0,0 +1,301 @@
+// ScoreBroadcast tests
+//
+// Several boards on an in-memory network: a frame sent to the group reaches every
+// other board that joined it, a unicast reaches one board, and the test can drop
+// the next frames to a board to play a lossy WiFi. Runs on the fake clock.
+//   pio test -e native -f test_score_broadcast
+
+#include <unity.h>
+#include <deque>
+#include <vector>
+#include "ScoreBroadcast.h"
+
+struct Datagram
+{
+    ScorePeer from;
+    std::vector<uint8_t> data;
+};
+
+class LoopbackTransport;
+
+struct LoopbackNetwork
+{
+    std::vector<LoopbackTransport *> boards;
+};
+
+class LoopbackTransport : public ScoreTransport
+{
+public:
+    LoopbackTransport(LoopbackNetwork &network) : _network(network)
+    {
+        _network.boards.push_back(this);
+        address = {(uint32_t)_network.boards.size(), 8366};
+    }
+
+    bool join() override
+    {
+        joined = true;
+        joins++;
+        inbox.clear();
+        return true;
+    }
+
+    void leave() override
+    {
+        joined = false;
+    }
+
+    bool send(const ScorePeer &to, const uint8_t *buf, size_t len) override
+    {
+        for (LoopbackTransport *board : _network.boards)
+        {
+            bool addressed = to.port == 0 ? board->joined && board != this : board->address.ip == to.ip && board->address.port == to.port;
+            if (addressed)
+            {
+                board->deliver(address, buf, len);
+            }
+        }
+        return true;
+    }
+
+    int receive(uint8_t *buf, size_t size, ScorePeer &from) override
+    {
+        if (inbox.empty())
+        {
+            return 0;
+        }
+        Datagram &d = inbox.front();
+        size_t len = d.data.size() < size ? d.data.size() : size;
+        memcpy(buf, d.data.data(), len);
+        from = d.from;
+        inbox.pop_front();
+        return len;
+    }
+
+    ScorePeer address;
+    bool joined = false;
+    int joins = 0;
+    int drop = 0; // frames still to be lost on the way to this board
+    unsigned long unicastsReceived = 0;
+    std::deque<Datagram> inbox;
+
+private:
+    void deliver(const ScorePeer &from, const uint8_t *buf, size_t len)
+    {
+        if (drop > 0)
+        {
+            drop--;
+            return;
+        }
+        inbox.push_back({from, std::vector<uint8_t>(buf, buf + len)});
+    }
+
+    LoopbackNetwork &_network;
+};
+
+static MatchDetails score(int runs, int overs, int wickets)
+{
+    MatchDetails details;
+    details.setRuns(runs);
+    details.setOvers(overs);
+    details.setWickets(wickets);
+    details.setInitialized(true);
+    return details;
+}
+
+void setUp()
+{
+    hostUseFakeClock(true);
+    hostAdvance(100000);
+}
+
+void tearDown()
+{
+    hostUseFakeClock(false);
+}
+
+void test_followers_apply_leader_score()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), aNet(net), bNet(net);
+    ScoreBroadcast leader(leaderNet), a(aNet), b(bNet);
+    leader.begin(ROLE_LEADER, 42);
+    a.begin(ROLE_FOLLOWER, 42);
+    b.begin(ROLE_FOLLOWER, 42);
+
+    MatchDetails published = score(123, 15, 4);
+    leader.publish(published);
+    MatchDetails received;
+    TEST_ASSERT_TRUE(a.poll(received));
+    TEST_ASSERT_EQUAL(123, received.getRuns());
+    TEST_ASSERT_EQUAL(15, received.getOvers());
+    TEST_ASSERT_EQUAL(4, received.getWickets());
+    MatchDetails receivedB;
+    TEST_ASSERT_TRUE(b.poll(receivedB));
+    TEST_ASSERT_EQUAL(123, receivedB.getRuns());
+
+    // the unchanged score is a heartbeat, not an update
+    leader.publish(published);
+    TEST_ASSERT_FALSE(a.poll(received));
+    TEST_ASSERT_EQUAL(2, a.getFramesReceived());
+}
+
+void test_lost_frame_is_repaired_by_the_next()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), followerNet(net);
+    ScoreBroadcast leader(leaderNet), follower(followerNet);
+    leader.begin(ROLE_LEADER, 42);
+    follower.begin(ROLE_FOLLOWER, 42);
+    MatchDetails received;
+
+    MatchDetails first = score(10, 2, 0);
+    leader.publish(first);
+    TEST_ASSERT_TRUE(follower.poll(received));
+
+    followerNet.drop = 1;
+    MatchDetails lost = score(14, 3, 0);
+    leader.publish(lost);
+    TEST_ASSERT_FALSE(follower.poll(received));
+
+    MatchDetails next = score(15, 3, 1);
+    leader.publish(next);
+    TEST_ASSERT_TRUE(follower.poll(received));
+    TEST_ASSERT_EQUAL(15, received.getRuns());
+    TEST_ASSERT_EQUAL(1, received.getWickets());
+    TEST_ASSERT_EQUAL(1, follower.getFramesMissed());
+}
+
+void test_late_follower_asks_and_leader_answers()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), followerNet(net);
+    ScoreBroadcast leader(leaderNet), follower(followerNet);
+    leader.begin(ROLE_LEADER, 42);
+    MatchDetails published = score(77, 9, 2);
+    leader.publish(published);
+
+    follower.begin(ROLE_FOLLOWER, 42);
+    MatchDetails received;
+    TEST_ASSERT_FALSE(follower.poll(received)); // sends the request to the group
+    TEST_ASSERT_FALSE(leader.poll(received));   // answers it by unicast
+    TEST_ASSERT_EQUAL(1, leader.getRequestsAnswered());
+    TEST_ASSERT_TRUE(follower.poll(received));
+    TEST_ASSERT_EQUAL(77, received.getRuns());
+}
+
+void test_quiet_leader_is_asked_directly()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), followerNet(net), otherNet(net);
+    ScoreBroadcast leader(leaderNet), follower(followerNet), other(otherNet);
+    leader.begin(ROLE_LEADER, 42);
+    follower.begin(ROLE_FOLLOWER, 42);
+    other.begin(ROLE_FOLLOWER, 42);
+    MatchDetails received;
+    MatchDetails published = score(50, 8, 1);
+    leader.publish(published);
+    TEST_ASSERT_TRUE(follower.poll(received));
+    other.poll(received);
+    leader.poll(received);
+
+    hostAdvance(SCORE_STALE_PERIOD / 2);
+    follower.poll(received);
+    TEST_ASSERT_EQUAL(0, leaderNet.inbox.size());
+
+    hostAdvance(SCORE_STALE_PERIOD);
+    follower.poll(received);
+    TEST_ASSERT_EQUAL(1, leaderNet.inbox.size());
+    TEST_ASSERT_EQUAL(0, otherNet.inbox.size()); // unicast to the leader, not the group
+
+    // asks again only after the retry period
+    leader.poll(received);
+    follower.poll(received); // the reply, a heartbeat
+    hostAdvance(SCORE_REQUEST_RETRY / 2);
+    follower.poll(received);
+    TEST_ASSERT_EQUAL(0, leaderNet.inbox.size());
+}
+
+void test_other_match_is_ignored()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), followerNet(net);
+    ScoreBroadcast leader(leaderNet), follower(followerNet);
+    leader.begin(ROLE_LEADER, 7);
+    follower.begin(ROLE_FOLLOWER, 42);
+    MatchDetails received;
+    follower.poll(received);
+    leader.poll(received); // a request for match 42 is not answered
+    TEST_ASSERT_EQUAL(0, leader.getRequestsAnswered());
+
+    MatchDetails published = score(1, 1, 1);
+    leader.publish(published);
+    TEST_ASSERT_FALSE(follower.poll(received));
+    TEST_ASSERT_EQUAL(0, follower.getFramesReceived());
+}
+
+void test_restarted_leader_is_followed()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), followerNet(net);
+    ScoreBroadcast leader(leaderNet), follower(followerNet);
+    leader.begin(ROLE_LEADER, 42);
+    follower.begin(ROLE_FOLLOWER, 42);
+    MatchDetails received;
+    for (int runs = 1; runs <= 5; runs++)
+    {
+        MatchDetails published = score(runs, 1, 0);
+        leader.publish(published);
+        TEST_ASSERT_TRUE(follower.poll(received));
+    }
+
+    // a new epoch starts its sequence numbers from 1 again
+    ScoreBroadcast restarted(leaderNet);
+    restarted.begin(ROLE_LEADER, 42);
+    MatchDetails published = score(6, 1, 0);
+    restarted.publish(published);
+    TEST_ASSERT_TRUE(follower.poll(received));
+    TEST_ASSERT_EQUAL(6, received.getRuns());
+}
+
+void test_begin_again_rejoins_and_switches_match()
+{
+    LoopbackNetwork net;
+    LoopbackTransport leaderNet(net), followerNet(net);
+    ScoreBroadcast leader(leaderNet), follower(followerNet);
+    leader.begin(ROLE_LEADER, 42);
+    follower.begin(ROLE_FOLLOWER, 42);
+    MatchDetails received;
+    MatchDetails first = score(30, 5, 1);
+    leader.publish(first);
+    TEST_ASSERT_TRUE(follower.poll(received));
+
+    // after a WiFi reconnect both boards join the group again
+    leader.begin(ROLE_LEADER, 42);
+    follower.begin(ROLE_FOLLOWER, 42);
+    TEST_ASSERT_EQUAL(2, followerNet.joins);
+    TEST_ASSERT_TRUE(followerNet.joined);
+    TEST_ASSERT_EQUAL(42, follower.getMatchId());
+
+    // the portal switches both boards to another match
+    leader.begin(ROLE_LEADER, 43);
+    follower.begin(ROLE_FOLLOWER, 43);
+    MatchDetails next = score(2, 1, 0);
+    leader.publish(next);
+    follower.poll(received);
+    TEST_ASSERT_EQUAL(2, received.getRuns());
+    TEST_ASSERT_EQUAL(43, follower.getMatchId());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_followers_apply_leader_score);
+    RUN_TEST(test_lost_frame_is_repaired_by_the_next);
+    RUN_TEST(test_late_follower_asks_and_leader_answers);
+    RUN_TEST(test_quiet_leader_is_asked_directly);
+    RUN_TEST(test_other_match_is_ignored);
+    RUN_TEST(test_restarted_leader_is_followed);
+    RUN_TEST(test_begin_again_rejoins_and_switches_match);
+    return UNITY_END();
+}
@@ -0,0 +1,329 @@
+// ScoreFetcher tests
+//
+// A scorecard served over plain HTTP on a loopback port by a server that honours
+// Range the way cricclubs.com does, including 416 for a range past the end of a
+// page that shrank, and answers 304 to a request that sends its ETag or
+// Last-Modified back.
+//   pio test -e native -f test_score_fetcher
+
+#include <unity.h>
+#include "LoopbackServer.h"
+#include "ScoreFetcher.h"
+
+#define SCORECARD "/NACL/viewScorecard.do?matchId=1&clubId=2"
+#define OTHER_SCORECARD "/NACL/viewScorecard.do?matchId=3&clubId=2"
+
+static std::string page(size_t padding, const char *score)
+{
+    std::string p = "<html><head>\n";
+    for (size_t i = 0; i < padding / 64; i++)
+    {
+        p += "<!-- padding padding padding padding padding padding padding -->\n";
+    }
+    p += "<meta name='description' content='A 99/9(20.0 overs) B " + std::string(score) + "(15.0 overs)'/>\n";
+    p += "</head><body>rest of the scorecard</body></html>\n";
+    return p;
+}
+
+class RangeServer : public LoopbackServer
+{
+public:
+    RangeServer()
+    {
+        start();
+    }
+
+    ~RangeServer() { stop(); }
+
+    void setPage(const std::string &p)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _page = p;
+    }
+
+    /// @brief Validators sent with the page, "" for none. A request that sends one of
+    /// them back is answered with 304.
+    void setValidators(const std::string &etag, const std::string &lastModified)
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        _etag = etag;
+        _lastModified = lastModified;
+    }
+
+    std::vector<std::string> headers(const char *name) // of every request, "" where it was not sent
+    {
+        std::lock_guard<std::mutex> guard(_lock);
+        std::vector<std::string> values;
+        for (const std::string &request : _requests)
+        {
+            values.push_back(header(request, name));
+        }
+        return values;
+    }
+
+    std::vector<std::string> ranges()
+    {
+        return headers("Range");
+    }
+
+    int notModified = 0;
+
+private:
+    void serve(int client) override
+    {
+        std::string request;
+        if (!readRequest(client, request))
+        {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(_lock);
+        _requests.push_back(request);
+        std::string range = header(request, "Range");
+
+        if ((!_etag.empty() && header(request, "If-None-Match") == _etag) ||
+            (!_lastModified.empty() && header(request, "If-Modified-Since") == _lastModified))
+        {
+            notModified++;
+            reply(client, "HTTP/1.1 304 Not Modified\r\n\r\n");
+            return;
+        }
+        std::string validators;
+        if (!_etag.empty())
+        {
+            validators += "ETag: " + _etag + "\r\n";
+        }
+        if (!_lastModified.empty())
+        {
+            validators += "Last-Modified: " + _lastModified + "\r\n";
+        }
+
+        if (range.empty())
+        {
+            reply(client, "HTTP/1.1 200 OK\r\n" + validators + "Content-Length: " + std::to_string(_page.size()) + "\r\n\r\n" + _page);
+            return;
+        }
+        // bytes=<first>-<last>
+        unsigned long first = strtoul(range.c_str() + range.find('=') + 1, nullptr, 10);
+        unsigned long last = strtoul(range.c_str() + range.find('-') + 1, nullptr, 10);
+        if (first >= _page.size())
+        {
+            // the error page happens to look like a description line
+            std::string body = "<meta name='description' content='range 1/1(1 not satisfiable'/>\n";
+            reply(client, "HTTP/1.1 416 Range Not Satisfiable\r\nContent-Range: bytes */" + std::to_string(_page.size()) +
+                              "\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body);
+            return;
+        }
+        last = std::min<unsigned long>(last, _page.size() - 1);
+        std::string part = _page.substr(first, last - first + 1);
+        reply(client, "HTTP/1.1 206 Partial Content\r\n" + validators + "Content-Range: bytes " + std::to_string(first) + "-" +
+                          std::to_string(last) + "/" + std::to_string(_page.size()) + "\r\nContent-Length: " + std::to_string(part.size()) +
+                          "\r\n\r\n" + part);
+    }
+
+    std::mutex _lock;
+    std::string _page;
+    std::string _etag;
+    std::string _lastModified;
+    std::vector<std::string> _requests;
+};
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static bool pollScore(ScoreFetcher &fetcher, MatchDetails &details, const char *path = SCORECARD)
+{
+    FetchBudget budget(FETCH_BUDGET_MS);
+    details = MatchDetails();
+    return fetcher.fetch(path, budget, details);
+}
+
+void test_learned_range_is_requested()
+{
+    RangeServer server;
+    server.setPage(page(20000, "123/4"));
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", server.port);
+    MatchDetails details;
+
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+    server.setPage(page(20000, "130/4"));
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(130, details.getRuns());
+
+    std::vector<std::string> ranges = server.ranges();
+    TEST_ASSERT_EQUAL(2, ranges.size());
+    TEST_ASSERT_TRUE(ranges[0].empty());
+    TEST_ASSERT_FALSE(ranges[1].empty());
+}
+
+void test_416_retries_the_full_page_in_the_same_poll()
+{
+    RangeServer server;
+    server.setPage(page(20000, "123/4"));
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", server.port);
+    MatchDetails details;
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+
+    // the page shrank below the learned range
+    server.setPage(page(0, "140/5"));
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(140, details.getRuns());
+    TEST_ASSERT_EQUAL(5, details.getWickets());
+
+    std::vector<std::string> ranges = server.ranges();
+    TEST_ASSERT_EQUAL(3, ranges.size());
+    TEST_ASSERT_FALSE(ranges[1].empty()); // answered with 416
+    TEST_ASSERT_TRUE(ranges[2].empty());  // full page right after
+
+    // the offsets learned from the short page are used from now on
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(140, details.getRuns());
+    TEST_ASSERT_EQUAL(4, server.ranges().size());
+    TEST_ASSERT_FALSE(server.ranges()[3].empty());
+}
+
+void test_new_source_does_not_inherit_the_learned_range()
+{
+    RangeServer first, second;
+    first.setPage(page(20000, "123/4"));
+    second.setPage(page(0, "123/4"));
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", first.port);
+    MatchDetails details;
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_FALSE(first.ranges()[1].empty());
+
+    // the same match from another host, whose page is laid out differently
+    fetcher.setSource("127.0.0.1", second.port);
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+    std::vector<std::string> ranges = second.ranges();
+    TEST_ASSERT_EQUAL(1, ranges.size());
+    TEST_ASSERT_TRUE(ranges[0].empty());
+}
+
+void test_new_match_does_not_inherit_the_learned_range()
+{
+    RangeServer server;
+    server.setPage(page(20000, "123/4"));
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", server.port);
+    MatchDetails details;
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_FALSE(server.ranges()[1].empty());
+
+    // another match, its description line further down than the old range reaches
+    server.setPage(page(40000, "45/1"));
+    TEST_ASSERT_TRUE(pollScore(fetcher, details, OTHER_SCORECARD));
+    TEST_ASSERT_EQUAL(45, details.getRuns());
+    std::vector<std::string> ranges = server.ranges();
+    TEST_ASSERT_EQUAL(3, ranges.size());
+    TEST_ASSERT_TRUE(ranges[2].empty());
+
+    // and the range learned from it is used for it
+    TEST_ASSERT_TRUE(pollScore(fetcher, details, OTHER_SCORECARD));
+    TEST_ASSERT_EQUAL(45, details.getRuns());
+    TEST_ASSERT_FALSE(server.ranges()[3].empty());
+}
+
+void test_matching_etag_is_not_modified()
+{
+    RangeServer server;
+    server.setPage(page(0, "123/4"));
+    server.setValidators("\"v1\"", "");
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", server.port);
+    MatchDetails first, details;
+    TEST_ASSERT_TRUE(pollScore(fetcher, first));
+
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    std::vector<std::string> sent = server.headers("If-None-Match");
+    TEST_ASSERT_TRUE(sent[0].empty());
+    TEST_ASSERT_EQUAL_STRING("\"v1\"", sent[1].c_str());
+    TEST_ASSERT_TRUE(server.headers("If-Modified-Since")[1].empty());
+    // no body, the cached score is handed back
+    TEST_ASSERT_EQUAL(1, server.notModified);
+    TEST_ASSERT_EQUAL(1, fetcher.getNotModified());
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+    TEST_ASSERT_EQUAL(4, details.getWickets());
+    TEST_ASSERT_EQUAL(first.getFingerprint(), details.getFingerprint());
+
+    // a new page has a new ETag, and is parsed
+    server.setPage(page(0, "130/5"));
+    server.setValidators("\"v2\"", "");
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(130, details.getRuns());
+    TEST_ASSERT_EQUAL(1, fetcher.getNotModified());
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL_STRING("\"v2\"", server.headers("If-None-Match")[3].c_str());
+    TEST_ASSERT_EQUAL(2, fetcher.getNotModified());
+    TEST_ASSERT_EQUAL(130, details.getRuns());
+}
+
+void test_matching_last_modified_is_not_modified()
+{
+    RangeServer server;
+    server.setPage(page(0, "123/4"));
+    server.setValidators("", "Sat, 17 Oct 2026 10:00:00 GMT");
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", server.port);
+    MatchDetails first, details;
+    TEST_ASSERT_TRUE(pollScore(fetcher, first));
+
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL_STRING("Sat, 17 Oct 2026 10:00:00 GMT", server.headers("If-Modified-Since")[1].c_str());
+    TEST_ASSERT_TRUE(server.headers("If-None-Match")[1].empty());
+    TEST_ASSERT_EQUAL(1, server.notModified);
+    TEST_ASSERT_EQUAL(1, fetcher.getNotModified());
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+    TEST_ASSERT_EQUAL(first.getFingerprint(), details.getFingerprint());
+}
+
+void test_unchanged_page_without_validators_is_recognised_by_fingerprint()
+{
+    RangeServer server;
+    server.setPage(page(0, "123/4"));
+    ScoreFetcher fetcher;
+    fetcher.setSource("127.0.0.1", server.port);
+    MatchDetails first, details;
+    TEST_ASSERT_TRUE(pollScore(fetcher, first));
+    TEST_ASSERT_EQUAL(0, fetcher.getSameFingerprint());
+
+    // nothing to send back, so the page comes again and the cached score is reused
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_TRUE(server.headers("If-None-Match")[1].empty());
+    TEST_ASSERT_TRUE(server.headers("If-Modified-Since")[1].empty());
+    TEST_ASSERT_EQUAL(0, server.notModified);
+    TEST_ASSERT_EQUAL(0, fetcher.getNotModified());
+    TEST_ASSERT_EQUAL(1, fetcher.getSameFingerprint());
+    TEST_ASSERT_EQUAL(123, details.getRuns());
+    TEST_ASSERT_EQUAL(first.getFingerprint(), details.getFingerprint());
+
+    // a changed description line is parsed
+    server.setPage(page(0, "124/4"));
+    TEST_ASSERT_TRUE(pollScore(fetcher, details));
+    TEST_ASSERT_EQUAL(124, details.getRuns());
+    TEST_ASSERT_EQUAL(1, fetcher.getSameFingerprint());
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_learned_range_is_requested);
+    RUN_TEST(test_416_retries_the_full_page_in_the_same_poll);
+    RUN_TEST(test_new_source_does_not_inherit_the_learned_range);
+    RUN_TEST(test_new_match_does_not_inherit_the_learned_range);
+    RUN_TEST(test_matching_etag_is_not_modified);
+    RUN_TEST(test_matching_last_modified_is_not_modified);
+    RUN_TEST(test_unchanged_page_without_validators_is_recognised_by_fingerprint);
+    return UNITY_END();
+}
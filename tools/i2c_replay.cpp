@@ -0,0 +1,156 @@
+// I2C Replay
+//
+// Host side companion of I2CTrace. Replays a trace exported from
+// http://<board>/i2c-trace on fake I2C buses, one per controller, and reports how
+// much of each bus the dials used and how long interrupts were held off.
+// Traces from before the bus column are replayed as all on Wire.
+//
+// Build and run on the host:
+//   g++ -O2 -o i2c_replay tools/i2c_replay.cpp
+//   curl -s http://<board>/i2c-trace | ./i2c_replay [-c clock_hz]
+//
+// The fake bus clocks every byte as 9 bits (8 data + ack) plus a start and a stop
+// condition, which is the minimum time the transaction occupies the wire. The
+// recorded duration is what the driver call really took, including the ESP32 I2C
+// driver overhead.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+struct Record
+{
+    uint32_t startUs;
+    uint32_t durationUs;
+    unsigned channel;
+    unsigned bytes;
+    bool irqOff;
+    unsigned bus;
+};
+
+struct ChannelStats
+{
+    unsigned long count = 0;
+    double wireUs = 0;
+    double driverUs = 0;
+};
+
+static double wireTimeUs(unsigned bytes, double clockHz)
+{
+    if (bytes == 0)
+    {
+        return 0;
+    }
+    return (bytes * 9 + 2) * 1e6 / clockHz;
+}
+
+int main(int argc, char **argv)
+{
+    double clockHz = 400000;
+    FILE *in = stdin;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-c") == 0 && i + 1 < argc)
+        {
+            clockHz = atof(argv[++i]);
+        }
+        else
+        {
+            in = fopen(argv[i], "r");
+            if (!in)
+            {
+                perror(argv[i]);
+                return 1;
+            }
+        }
+    }
+
+    std::vector<Record> records;
+    char line[256];
+    while (fgets(line, sizeof(line), in))
+    {
+        Record r;
+        unsigned long start, duration;
+        int irqOff;
+        r.bus = 0;
+        if (sscanf(line, "%lu,%lu,%u,%u,%d,%u", &start, &duration, &r.channel, &r.bytes, &irqOff, &r.bus) < 5)
+        {
+            continue; // header or garbage
+        }
+        r.startUs = start;
+        r.durationUs = duration;
+        r.irqOff = irqOff != 0;
+        records.push_back(r);
+    }
+    if (records.empty())
+    {
+        fprintf(stderr, "no trace records\n");
+        return 1;
+    }
+
+    // Replay on the fake bus. Times are taken relative to the first record so that
+    // a micros() wrap inside the trace does not matter.
+    uint32_t origin = records[0].startUs;
+    std::map<unsigned, double> busFreeAt;
+    std::map<unsigned, double> busWireUs;
+    double wireUs = 0;
+    double driverUs = 0;
+    double queuedUs = 0;
+    double end = 0;
+    double longestIrqOff = 0;
+    double longestIrqOffAt = 0;
+    unsigned long totalBytes = 0;
+    std::map<unsigned, ChannelStats> channels;
+
+    for (const Record &r : records)
+    {
+        double start = (uint32_t)(r.startUs - origin);
+        double wire = wireTimeUs(r.bytes, clockHz);
+        double &freeAt = busFreeAt[r.bus];
+        if (start < freeAt)
+        {
+            queuedUs += freeAt - start; // would have waited for the bus
+            start = freeAt;
+        }
+        freeAt = start + wire;
+        wireUs += wire;
+        busWireUs[r.bus] += wire;
+        driverUs += r.durationUs;
+        totalBytes += r.bytes;
+        end = std::max(end, std::max(start + r.durationUs, freeAt));
+        if (r.irqOff && r.durationUs > longestIrqOff)
+        {
+            longestIrqOff = r.durationUs;
+            longestIrqOffAt = start;
+        }
+        ChannelStats &c = channels[r.channel];
+        c.count++;
+        c.wireUs += wire;
+        c.driverUs += r.durationUs;
+    }
+
+    double span = end > 0 ? end : 1;
+    printf("records:                 %zu\n", records.size());
+    printf("trace span:              %.1f ms\n", span / 1000);
+    printf("bus clock:               %.0f Hz\n", clockHz);
+    printf("bytes on the bus:        %lu\n", totalBytes);
+    printf("wire time:               %.1f ms\n", wireUs / 1000);
+    for (const auto &it : busWireUs)
+    {
+        printf("  Wire%-3s                %.1f ms (%.2f%% bus utilization)\n", it.first ? "1" : "", it.second / 1000, 100 * it.second / span);
+    }
+    printf("driver time:             %.1f ms (%.2f%% of the span)\n", driverUs / 1000, 100 * driverUs / span);
+    printf("time queued for the bus: %.1f ms\n", queuedUs / 1000);
+    printf("longest interrupts-off:  %.0f us at +%.1f ms\n", longestIrqOff, longestIrqOffAt / 1000);
+    printf("\nchannel  count  wire_ms  driver_ms  avg_driver_us\n");
+    for (const auto &it : channels)
+    {
+        const ChannelStats &c = it.second;
+        printf("%7u  %5lu  %7.2f  %9.2f  %13.0f\n", it.first, c.count, c.wireUs / 1000, c.driverUs / 1000, c.driverUs / c.count);
+    }
+    return 0;
+}
@@ -0,0 +1,296 @@
+// Score Proxy
+//
+// Linux side companion of ProxyClient. Scrapes the cricclubs scorecard of every
+// match the boards ask for, once per interval no matter how many boards show it,
+// with the same extraction as the firmware (src/ScoreParser.cpp). Boards get a few
+// byte reply holding only the fields that changed since the sequence number they
+// already have, and TLS runs on this host instead of on the microcontrollers.
+// Every reply says how long ago the score was last scraped, so while scrapes fail
+// the boards can tell the snapshot has gone stale and fetch the scorecard themselves.
+//
+// Build and run on the host (needs curl for the HTTPS fetch):
+//   g++ -O2 -std=c++17 -Iinclude -o scoreproxy tools/scoreproxy.cpp src/ScoreParser.cpp src/ProxyFrame.cpp -lpthread
+//   ./scoreproxy [-p port] [-i scrape_interval_s] [-s server] [-v]
+// then set "Score proxy host" on the boards to this host's address.
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include "ProxyFrame.h"
+#include "ScoreParser.h"
+
+#define HISTORY_LEN 32        // snapshots kept per match to answer deltas
+#define IDLE_TIMEOUT 600      // stop scraping a match nobody asked for in 10 minutes
+#define FORGET_TIMEOUT 3600   // and forget it after an hour
+#define FETCH_TIMEOUT 15      // seconds allowed for one scrape
+
+struct Snapshot
+{
+    uint32_t seq;
+    uint16_t runs;
+    uint16_t overs;
+    uint8_t wickets;
+};
+
+struct Match
+{
+    std::string tournament;
+    uint32_t matchId;
+    uint32_t clubId;
+    std::deque<Snapshot> history;
+    time_t lastRequest = 0;
+    time_t lastScrape = 0;
+    time_t lastGoodScrape = 0; // last scrape that found the score, changed or not
+    unsigned long requests = 0;
+    unsigned long scrapes = 0;
+    unsigned long failures = 0;
+};
+
+static std::map<std::string, Match> matches;
+static std::mutex matchesLock;
+static std::condition_variable scrapeWanted;
+static uint16_t epoch;
+static std::string server = "cricclubs.com";
+static int scrapeInterval = 30;
+static bool verbose = false;
+
+static bool validTournament(const char *tournament)
+{
+    if (*tournament == '\0')
+    {
+        return false;
+    }
+    for (const char *c = tournament; *c; c++)
+    {
+        if (!isalnum((unsigned char)*c) && *c != '-' && *c != '_')
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static std::string matchKey(const ProxyRequest &request)
+{
+    return std::string(request.tournament) + "/" + std::to_string(request.clubId) + "/" + std::to_string(request.matchId);
+}
+
+/// @brief Fetches the scorecard with curl and parses it like MatchDetails does:
+/// line by line, stopping at the first description line with a score.
+static bool scrape(const std::string &tournament, uint32_t matchId, uint32_t clubId, ParsedScore &score)
+{
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd), "curl -s --max-time %d 'https://%s/%s/viewScorecard.do?matchId=%u&clubId=%u'",
+             FETCH_TIMEOUT, server.c_str(), tournament.c_str(), matchId, clubId);
+    FILE *page = popen(cmd, "r");
+    if (!page)
+    {
+        return false;
+    }
+    char *line = nullptr;
+    size_t size = 0;
+    bool found = false;
+    while (!found && getline(&line, &size, page) >= 0)
+    {
+        found = parseScoreLine(line, score);
+    }
+    free(line);
+    pclose(page);
+    return found;
+}
+
+static void scraper()
+{
+    std::unique_lock<std::mutex> lock(matchesLock);
+    while (true)
+    {
+        scrapeWanted.wait_for(lock, std::chrono::seconds(1));
+        time_t now = time(nullptr);
+        for (auto it = matches.begin(); it != matches.end();)
+        {
+            Match &m = it->second;
+            if (now - m.lastRequest > FORGET_TIMEOUT)
+            {
+                it = matches.erase(it);
+                continue;
+            }
+            if (now - m.lastRequest > IDLE_TIMEOUT || now - m.lastScrape < scrapeInterval)
+            {
+                ++it;
+                continue;
+            }
+            std::string key = it->first;
+            std::string tournament = m.tournament;
+            uint32_t matchId = m.matchId;
+            uint32_t clubId = m.clubId;
+            m.lastScrape = now;
+
+            lock.unlock();
+            ParsedScore score;
+            bool ok = scrape(tournament, matchId, clubId, score);
+            lock.lock();
+
+            // the map may have changed while unlocked
+            auto current = matches.find(key);
+            if (current != matches.end())
+            {
+                Match &cm = current->second;
+                cm.scrapes++;
+                if (!ok)
+                {
+                    cm.failures++;
+                    fprintf(stderr, "%s: no score found\n", key.c_str());
+                }
+                else
+                {
+                    cm.lastGoodScrape = time(nullptr);
+                }
+                if (ok && (cm.history.empty() || cm.history.back().runs != score.runs || cm.history.back().overs != score.overs || cm.history.back().wickets != score.wickets))
+                {
+                    Snapshot s;
+                    s.seq = cm.history.empty() ? 1 : cm.history.back().seq + 1;
+                    s.runs = score.runs;
+                    s.overs = score.overs;
+                    s.wickets = score.wickets;
+                    cm.history.push_back(s);
+                    if (cm.history.size() > HISTORY_LEN)
+                    {
+                        cm.history.pop_front();
+                    }
+                    fprintf(stderr, "%s: seq %u %d/%d (%d)\n", key.c_str(), s.seq, score.runs, score.wickets, score.overs);
+                }
+            }
+            it = matches.upper_bound(key);
+        }
+    }
+}
+
+/// @brief Builds the reply to a request: the fields changed since the board's seq,
+/// all of them if the seq is from another epoch or no longer in the history.
+static ProxyReply answer(const ProxyRequest &request)
+{
+    ProxyReply reply = {};
+    reply.epoch = epoch;
+
+    std::lock_guard<std::mutex> lock(matchesLock);
+    std::string key = matchKey(request);
+    Match &m = matches[key];
+    if (m.requests == 0)
+    {
+        m.tournament = request.tournament;
+        m.matchId = request.matchId;
+        m.clubId = request.clubId;
+        scrapeWanted.notify_one();
+    }
+    m.requests++;
+    m.lastRequest = time(nullptr);
+    if (m.history.empty())
+    {
+        return reply; // seq 0, nothing scraped yet
+    }
+
+    const Snapshot &latest = m.history.back();
+    reply.seq = latest.seq;
+    reply.runs = latest.runs;
+    reply.overs = latest.overs;
+    reply.wickets = latest.wickets;
+    reply.age = std::min<time_t>(m.lastRequest - m.lastGoodScrape, 0xffff);
+    reply.mask = PROXY_ALL;
+    if (request.epoch == epoch)
+    {
+        for (const Snapshot &s : m.history)
+        {
+            if (s.seq == request.seq)
+            {
+                reply.mask = (s.runs != latest.runs ? PROXY_RUNS : 0) |
+                             (s.overs != latest.overs ? PROXY_OVERS : 0) |
+                             (s.wickets != latest.wickets ? PROXY_WICKETS : 0);
+                break;
+            }
+        }
+    }
+    return reply;
+}
+
+int main(int argc, char **argv)
+{
+    int port = PROXY_PORT;
+    int opt;
+    while ((opt = getopt(argc, argv, "p:i:s:v")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p':
+            port = atoi(optarg);
+            break;
+        case 'i':
+            scrapeInterval = atoi(optarg);
+            break;
+        case 's':
+            server = optarg;
+            break;
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-p port] [-i scrape_interval_s] [-s server] [-v]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    std::random_device random;
+    do
+    {
+        epoch = random() & 0xffff;
+    } while (epoch == 0); // boards use epoch 0 for "no score yet"
+
+    int sock = socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons(port);
+    if (sock < 0 || bind(sock, (sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        perror("bind");
+        return 1;
+    }
+    fprintf(stderr, "scoreproxy listening on udp/%d, epoch %u, scraping %s every %d s\n", port, epoch, server.c_str(), scrapeInterval);
+
+    std::thread(scraper).detach();
+
+    uint8_t in[PROXY_REQUEST_MAX_LEN + 1];
+    uint8_t out[PROXY_REPLY_MAX_LEN];
+    while (true)
+    {
+        sockaddr_in from;
+        socklen_t fromLen = sizeof(from);
+        ssize_t len = recvfrom(sock, in, sizeof(in), 0, (sockaddr *)&from, &fromLen);
+        ProxyRequest request;
+        if (len <= 0 || !decodeProxyRequest(in, len, request) || !validTournament(request.tournament))
+        {
+            continue;
+        }
+        ProxyReply reply = answer(request);
+        size_t n = encodeProxyReply(reply, out, sizeof(out));
+        sendto(sock, out, n, 0, (sockaddr *)&from, fromLen);
+        if (verbose)
+        {
+            fprintf(stderr, "%s:%d %s seq %u -> seq %u mask %u age %u s (%zu bytes)\n", inet_ntoa(from.sin_addr), ntohs(from.sin_port),
+                    matchKey(request).c_str(), request.seq, reply.seq, reply.mask, reply.age, n);
+        }
+    }
+}
@@ -0,0 +1,170 @@
+# Size Budget
+#
+# PlatformIO pre script for [env:m5stick-c-min].
+#
+# -flto and -Os in build_flags only reach the compiler, so this adds them to the
+# link, where LTO actually happens, and asks the linker for a map file. After the
+# link it prints the flash and static RAM of every input object from the map,
+# largest first. Framework and library members are listed one by one; the project
+# sources come out of LTO as ltrans partitions, so they are listed pre-LTO from their
+# fat objects (-ffat-lto-objects) as a guide to which source grew.
+#
+# Static RAM is DRAM data and bss plus the code placed in IRAM, which is copied there
+# from flash at boot and takes from the same 320 KB.
+#
+# The budgets are the measured sizes of a known good build plus headroom:
+#   custom_flash_baseline / custom_ram_baseline  - bytes, from a build of this env
+#   custom_size_headroom                         - percent allowed on top
+# The build fails when the firmware is over a budget, and when a baseline is missing:
+# it then prints the measured lines to put into platformio.ini.
+
+import os
+import re
+import subprocess
+
+Import("env")
+
+env.Append(LINKFLAGS=["-flto", "-Os", "-Wl,-Map=${BUILD_DIR}/${PROGNAME}.map"])
+
+OUTPUT_SECTION = re.compile(r"^(\.\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+))?")
+INPUT_SECTION = re.compile(r"^ (\.\S+|COMMON)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+))?$")
+INPUT_CONTINUED = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(.+)$")
+
+
+def section_kind(name):
+    """flash, ram or both, for an allocated output section of the ESP32 linker script"""
+    if "bss" in name or "noinit" in name:
+        return "ram"
+    if ".data" in name or name.startswith(".iram0"):
+        return "both"  # initialised data and IRAM code are stored in flash and copied to RAM
+    return "flash"
+
+
+def map_sizes(path):
+    """{input object: [flash, ram]} from the memory map part of a GNU ld map file"""
+    sizes = {}
+    kind = None
+    section = None  # input section whose address and size wrapped onto the next line
+    in_map = False
+    with open(path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not in_map:
+                in_map = line.startswith("Linker script and memory map")
+                continue
+            entry = None
+            m = INPUT_CONTINUED.match(line) if section else None
+            section = None
+            if m:
+                entry = m.groups()
+            elif OUTPUT_SECTION.match(line):
+                # debug and other unallocated sections sit at address 0
+                m = OUTPUT_SECTION.match(line)
+                kind = section_kind(m.group(1)) if m.group(2) is None or int(m.group(2), 16) != 0 else None
+            else:
+                m = INPUT_SECTION.match(line)
+                if m and m.group(2) is None:
+                    section = m.group(1)
+                elif m:
+                    entry = m.group(2, 3, 4)
+            if entry is None or kind is None:
+                continue
+            address, size, name = int(entry[0], 16), int(entry[1], 16), entry[2].strip()
+            if address == 0 or size == 0:
+                continue
+            flash_ram = sizes.setdefault(object_name(name), [0, 0])
+            if kind in ("flash", "both"):
+                flash_ram[0] += size
+            if kind in ("ram", "both"):
+                flash_ram[1] += size
+    return sizes
+
+
+def object_name(path):
+    """archive(member) or object file name, with the LTO partitions folded into one"""
+    if ".ltrans" in path:
+        return "project sources (after LTO)"
+    m = re.match(r"(.*\.a)\((.*)\)$", path)
+    if m:
+        return "%s(%s)" % (os.path.basename(m.group(1)), m.group(2))
+    return os.path.basename(path)
+
+
+def elf_sizes(sizetool, path):
+    """flash and static RAM of the firmware, from the allocated sections of size's sysv format"""
+    flash, ram = 0, 0
+    for line in subprocess.check_output([sizetool, "-A", path]).decode().splitlines():
+        fields = line.split()
+        if len(fields) != 3 or not fields[0].startswith(".") or not fields[1].isdigit() or int(fields[2]) == 0:
+            continue
+        kind = section_kind(fields[0])
+        if kind in ("flash", "both"):
+            flash += int(fields[1])
+        if kind in ("ram", "both"):
+            ram += int(fields[1])
+    return flash, ram
+
+
+def section_sizes(sizetool, path):
+    """text, data and bss of an object or elf file, from size's berkeley format"""
+    out = subprocess.check_output([sizetool, "-B", path]).decode().splitlines()
+    text, data, bss = 0, 0, 0
+    for line in out[1:]:
+        fields = line.split()
+        text += int(fields[0])
+        data += int(fields[1])
+        bss += int(fields[2])
+    return text, data, bss
+
+
+def option(name, default=0):
+    value = env.GetProjectOption(name, default)
+    return int(value) if str(value).strip() else default
+
+
+def check_size_budget(source, target, env):
+    sizetool = env.subst("$SIZETOOL")
+    build_dir = env.subst("$BUILD_DIR")
+    elf = str(source[0])
+
+    print("Size per input object after the link (flash, static RAM):")
+    for name, (flash, ram) in sorted(map_sizes(env.subst("${BUILD_DIR}/${PROGNAME}.map")).items(), key=lambda i: -i[1][0]):
+        print("  %8d %8d  %s" % (flash, ram, name))
+
+    print("Project sources before LTO (flash, static RAM), a guide only:")
+    objects = []
+    for root, _, files in os.walk(os.path.join(build_dir, "src")):
+        for name in files:
+            if name.endswith(".o"):
+                path = os.path.join(root, name)
+                text, data, bss = section_sizes(sizetool, path)
+                objects.append((text + data, data + bss, os.path.relpath(path, build_dir)))
+    for flash, ram, name in sorted(objects, reverse=True):
+        print("  %8d %8d  %s" % (flash, ram, name))
+
+    flash, ram = elf_sizes(sizetool, elf)
+    flash_baseline = option("custom_flash_baseline")
+    ram_baseline = option("custom_ram_baseline")
+    headroom = option("custom_size_headroom", 5)
+    if not flash_baseline or not ram_baseline:
+        print("Error: no size baseline. Firmware: flash %d bytes, static RAM %d bytes (IRAM included)." % (flash, ram))
+        print("Once this build is known good, set in [env:%s]:" % env.subst("$PIOENV"))
+        print("  custom_flash_baseline = %d\n  custom_ram_baseline = %d" % (flash, ram))
+        return 1
+    flash_budget = flash_baseline * (100 + headroom) // 100
+    ram_budget = ram_baseline * (100 + headroom) // 100
+    print("Firmware: flash %d of %d bytes, static RAM %d of %d bytes (baseline + %d%%)" % (flash, flash_budget, ram, ram_budget, headroom))
+
+    failed = False
+    if flash > flash_budget:
+        print("Error: flash is %d bytes over budget" % (flash - flash_budget))
+        failed = True
+    if ram > ram_budget:
+        print("Error: static RAM is %d bytes over budget" % (ram - ram_budget))
+        failed = True
+    if failed:
+        # the firmware is left in place, but the build reports failure
+        return 1
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", check_size_budget)